@@ -122,5 +122,5 @@ echo ""
 print_success "Debug build and test completed successfully!"
 echo ""
 print_info "Build artifacts location: $BUILD_DIR"
-print_info "Test executable: $BUILD_DIR/test/test_danp_ftp"
+print_info "Test executables: $BUILD_DIR/test/test_danp_ftp_*"
 echo ""
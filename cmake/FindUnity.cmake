@@ -24,7 +24,7 @@ if(Find_Unity_LIBRARIES AND Find_Unity_INCLUDE_DIRS)
     #message(STATUS "Unity include directories: ${Find_Unity_INCLUDE_DIRS}")
 endif()
 
-if(NOT TARGET unity)
+if(Unity_FOUND AND NOT TARGET unity)
     add_library(unity UNKNOWN IMPORTED)
     set_target_properties(unity PROPERTIES
         IMPORTED_LOCATION ${Find_Unity_LIBRARIES}
@@ -7,10 +7,12 @@
 
 /* Includes */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
 #include <sys/types.h>
 #include "danp/danp.h"
+#include "danp/ftp/danp_ftp_sha256.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,6 +21,13 @@ extern "C" {
 
 /* Configurations */
 
+#ifndef CONFIG_DANP_FTP_MAX_FILE_ID_LEN
+#define CONFIG_DANP_FTP_MAX_FILE_ID_LEN       (32)
+#endif
+
+#ifndef CONFIG_DANP_FTP_WORKSPACE_POOL_SIZE
+#define CONFIG_DANP_FTP_WORKSPACE_POOL_SIZE   (1)
+#endif
 
 /* Definitions */
 
@@ -28,15 +37,25 @@ extern "C" {
 #define DANP_FTP_STATUS_CONNECTION_FAILED     (-3)
 #define DANP_FTP_STATUS_TRANSFER_FAILED       (-4)
 #define DANP_FTP_STATUS_FILE_NOT_FOUND        (-5)
+#define DANP_FTP_STATUS_CANCELLED             (-6)
+#define DANP_FTP_STATUS_DIGEST_MISMATCH       (-7)
 
 #define DANP_FTP_CRC32_POLYNOMIAL             (0xEDB88320U)
 
+#define DANP_FTP_BATCH_MAX_FILES              (255)
+#define DANP_FTP_MAX_CHUNK_SIZE               (DANP_MAX_PACKET_SIZE - sizeof(danp_ftp_header_t))
+#define DANP_FTP_MAX_FILE_ID_LEN              (CONFIG_DANP_FTP_MAX_FILE_ID_LEN)
+#define DANP_FTP_WORKSPACE_POOL_SIZE          (CONFIG_DANP_FTP_WORKSPACE_POOL_SIZE)
+
 /* Types */
 
 typedef ssize_t danp_ftp_status_t;
 
 typedef struct danp_ftp_handle_s danp_ftp_handle_t;
 
+typedef struct danp_ftp_rate_limiter_s danp_ftp_rate_limiter_t;
+typedef struct danp_ftp_scheduler_s danp_ftp_scheduler_t;
+
 typedef enum danp_ftp_packet_type_e
 {
     DANP_FTP_PACKET_TYPE_COMMAND = 0,
@@ -65,6 +84,31 @@ typedef struct danp_ftp_header_s
     uint32_t crc;
 } danp_ftp_header_t;
 
+/**
+ * @brief Processes a run of identical bytes received as a hole record.
+ *
+ * Lets a sink seek or punch a hole instead of writing `length` copies of `value`. When the file
+ * ends in a run (`more` is 0), the sink callback is called once more afterwards with a zero-length
+ * chunk at the end offset and `more` set to 0, so that sinks which flush, sync or drain on the
+ * final chunk still see it.
+ *
+ * @param offset  Offset of the run within the file.
+ * @param length  Number of bytes in the run.
+ * @param value   Value of every byte in the run, 0 for a zero run.
+ * @param more    Set to 1 if more data will follow, else 0.
+ * @return
+ *   - <0: Error code (see DANP_FTP_STATUS_*).
+ *   - >=0: Success.
+ */
+typedef danp_ftp_status_t (*danp_ftp_hole_cb_t)(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    size_t length,
+    uint8_t value,
+    uint8_t more,
+    void *user_data
+);
+
 typedef struct danp_ftp_transfer_config_s
 {
     const uint8_t *file_id;                        /* File name/id */
@@ -72,8 +116,34 @@ typedef struct danp_ftp_transfer_config_s
     uint16_t chunk_size;                           /* Chunk size in bytes */
     uint32_t timeout_ms;                           /* Timeout in milliseconds */
     uint8_t max_retries;                           /* Maximum number of retries */
+    bool verify_digest;                            /* End-to-end SHA-256 of the whole file */
+    bool elide_runs;                               /* Send repeated-byte chunks as hole records */
+    danp_ftp_hole_cb_t hole_callback;              /* Optional receive hole handler */
 } danp_ftp_transfer_config_t;
 
+typedef struct danp_ftp_file_ref_s
+{
+    const uint8_t *file_id;                        /* File name/id */
+    size_t file_id_len;                            /* File name/id len */
+} danp_ftp_file_ref_t;
+
+typedef struct danp_ftp_batch_config_s
+{
+    const danp_ftp_file_ref_t *files;              /* Files to fetch, in order */
+    size_t file_count;                             /* Number of files, up to 255 */
+    uint32_t timeout_ms;                           /* Timeout in milliseconds */
+    danp_ftp_status_t *file_status;                /* Optional per-file result (bytes or error) */
+} danp_ftp_batch_config_t;
+
+typedef struct danp_ftp_manifest_entry_s
+{
+    uint8_t file_id[DANP_FTP_MAX_FILE_ID_LEN];     /* File name/id */
+    uint8_t file_id_len;                           /* File name/id len */
+    uint32_t size;                                 /* File size in bytes */
+    uint32_t mtime;                                /* Modification stamp */
+    uint32_t checksum;                             /* File checksum */
+} danp_ftp_manifest_entry_t;
+
 /**
  * @brief Reads a chunk of data from the FTP source.
  *
@@ -89,6 +159,7 @@ typedef struct danp_ftp_transfer_config_s
  * @note
  *   - `length` specifies the maximum number of bytes to read into `data`.
  *   - If `more` is provided, it indicates whether additional data remains after this chunk.
+ *   - Returning 0 after promising more ends the transfer with an empty last chunk.
  */
 typedef danp_ftp_status_t (*danp_ftp_source_cb_t)(
     danp_ftp_handle_t *handle,
@@ -121,6 +192,78 @@ typedef danp_ftp_status_t (*danp_ftp_sink_cb_t)(
     void *user_data
 );
 
+/**
+ * @brief Processes a chunk of FTP data received in a batch session.
+ *
+ * @param file_index Index of the file in `danp_ftp_batch_config_t.files` this chunk belongs to.
+ * @param offset     Offset of the chunk within its file.
+ * @param data       Pointer to the data buffer.
+ * @param length     Length of the data buffer.
+ * @param more       Set to 1 if more data will follow for this file, else 0.
+ * @return
+ *   - <0: Error code (see DANP_FTP_STATUS_*), aborts the whole batch.
+ *   - >=0: Number of bytes consumed from `data`.
+ */
+typedef danp_ftp_status_t (*danp_ftp_batch_sink_cb_t)(
+    danp_ftp_handle_t *handle,
+    size_t file_index,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data
+);
+
+/**
+ * @brief Processes one entry of a remote file manifest.
+ *
+ * @param entry Pointer to the decoded manifest entry, only valid during the call.
+ * @return
+ *   - <0: Error code (see DANP_FTP_STATUS_*), aborts the listing.
+ *   - >=0: Continue with the next entry.
+ */
+typedef danp_ftp_status_t (*danp_ftp_list_cb_t)(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_manifest_entry_t *entry,
+    void *user_data
+);
+
+/**
+ * @brief Reports the progress of a transfer.
+ *
+ * Called from the thread running the transfer, so it must return quickly.
+ *
+ * @param bytes_transferred  Bytes of the file transferred so far.
+ */
+typedef void (*danp_ftp_progress_cb_t)(
+    danp_ftp_handle_t *handle,
+    size_t bytes_transferred,
+    void *user_data
+);
+
+/**
+ * @brief Packet buffers and digest state used by a transfer.
+ *
+ * Every transfer needs exactly one workspace: outgoing packets (commands, data chunks, ACKs) are
+ * built in place in `tx_packet`, incoming ones land in `rx_packet`, and source and sink callbacks
+ * work directly on those payloads. `digest` is only used by transfers with `verify_digest` set.
+ * Peak buffer memory per transfer is therefore
+ * sizeof(danp_ftp_workspace_t) = 2 * DANP_MAX_PACKET_SIZE + sizeof(danp_ftp_sha256_t) (about
+ * 112 bytes), wherever the workspace lives:
+ *   - Attached with danp_ftp_set_workspace(): caller-owned, no packet buffer on the stack.
+ *   - CONFIG_DANP_FTP_STATIC_WORKSPACE: danp_ftp_init() claims one of
+ *     DANP_FTP_WORKSPACE_POOL_SIZE static workspaces; transfers without a workspace fail.
+ *   - Otherwise: a workspace on the stack of the transfer call.
+ * The remaining stack use of a transfer is a few hundred bytes of frames plus the callbacks;
+ * build with -DDANP_FTP_STACK_USAGE=ON and run scripts/stack_report.py to measure it.
+ */
+typedef struct danp_ftp_workspace_s
+{
+    uint8_t tx_packet[DANP_MAX_PACKET_SIZE];      /* Outgoing packet */
+    uint8_t rx_packet[DANP_MAX_PACKET_SIZE];      /* Incoming packet */
+    danp_ftp_sha256_t digest;                     /* Whole-file digest, with `verify_digest` */
+} danp_ftp_workspace_t;
+
 typedef struct danp_ftp_handle_s
 {
     danp_socket_t *socket;
@@ -128,6 +271,16 @@ typedef struct danp_ftp_handle_s
     uint16_t sequence_number;
     danp_ftp_state_t state;
     size_t total_bytes_transferred;
+    danp_ftp_rate_limiter_t *rate_limiter;
+    danp_ftp_scheduler_t *scheduler;
+    uint8_t priority;
+    bool has_link;
+    danp_ftp_workspace_t *workspace;
+    danp_ftp_progress_cb_t progress_callback;
+    void *progress_user_data;
+    uint64_t progress_interval_us;
+    uint64_t progress_last_us;
+    bool is_cancelled;
     bool is_initialized;
 } danp_ftp_handle_t;
 
@@ -162,12 +315,76 @@ extern void danp_ftp_deinit(
     danp_ftp_handle_t *handle                      /* FTP handle */
 );
 
+/**
+ * @brief Attaches a caller-owned workspace to an FTP handle.
+ *
+ * All later transfers on the handle use the workspace instead of stack buffers. A workspace
+ * claimed from the static pool by danp_ftp_init() is returned to the pool. The workspace must
+ * stay valid until it is replaced or the handle is deinitialized, and must not be shared by
+ * handles that transfer concurrently.
+ *
+ * @param[in] handle     Pointer to the initialized FTP handle.
+ * @param[in] workspace  Pointer to the workspace, NULL to detach it.
+ */
+extern void danp_ftp_set_workspace(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *workspace                /* Workspace */
+);
+
+/**
+ * @brief Cancels the transfer running on an FTP handle.
+ *
+ * Safe to call from any thread while another thread runs a transfer on the handle. An ABORT
+ * command is sent to the remote side at once from the calling thread, so it drops the transfer
+ * without waiting for a timeout. The transfer stops at its next packet or within
+ * CONFIG_DANP_FTP_CANCEL_POLL_MS if it is waiting for one, and returns DANP_FTP_STATUS_CANCELLED.
+ * A transfer queued for the link of its scheduler leaves the queue at once, and one paced by a
+ * rate limiter stops within CONFIG_DANP_FTP_CANCEL_POLL_MS.
+ * A transfer that has not yet sent its request when this is called is not affected. A transfer
+ * that receives an ABORT from the remote side stops the same way and returns
+ * DANP_FTP_STATUS_CANCELLED.
+ *
+ * @param[in] handle Pointer to the initialized FTP handle.
+ *
+ * @return Status code, DANP_FTP_STATUS_ERROR if no transfer is running.
+ */
+extern danp_ftp_status_t danp_ftp_cancel(
+    danp_ftp_handle_t *handle                      /* FTP handle */
+);
+
+/**
+ * @brief Sets the progress callback of an FTP handle.
+ *
+ * The callback is invoked as packets are exchanged, at most once per `interval_ms`, and once more
+ * when a transfer completes. With no callback set, transfers pay a single pointer check per packet.
+ *
+ * @param[in] handle       Pointer to the initialized FTP handle.
+ * @param[in] callback     Progress callback, NULL to disable progress reports.
+ * @param[in] interval_ms  Minimum time between two reports, 0 to report every packet.
+ * @param[in] user_data    User-defined data passed to the callback.
+ */
+extern void danp_ftp_set_progress(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_progress_cb_t callback,               /* Progress callback */
+    uint32_t interval_ms,                          /* Minimum report interval */
+    void *user_data
+);
+
 /**
  * @brief Transmits data using the FTP protocol.
  *
  * This function initiates a data transfer using the FTP handle and the provided transfer configuration.
  * The source callback is used to provide data to be transmitted.
  *
+ * With `verify_digest` set, a SHA-256 of the file is computed as chunks leave the source and sent
+ * in a trailer after the last chunk. The transfer only succeeds if the receiver's digest of the
+ * data it accepted matches, which catches errors the per-packet CRC cannot see. A mismatch is
+ * final and returns DANP_FTP_STATUS_DIGEST_MISMATCH at once, without retrying the trailer.
+ *
+ * With `elide_runs` set, chunks made of one repeated byte (zero-filled regions of disk images,
+ * preallocated logs) are not sent; consecutive ones are merged into a single hole record of a few
+ * bytes carrying the run length and value.
+ *
  * @param[in]  handle           Pointer to the initialized FTP handle.
  * @param[in]  transfer_config  Pointer to the transfer configuration structure.
  * @param[in]  callback         Source callback function to provide data.
@@ -188,6 +405,13 @@ extern danp_ftp_status_t danp_ftp_transmit(
  * This function initiates a data reception using the FTP handle and the provided transfer configuration.
  * The sink callback is used to process received data.
  *
+ * With `verify_digest` set, the data is hashed as it is passed to the sink and checked against the
+ * sender's SHA-256 trailer before success is reported, so the file does not have to be read back.
+ * On a mismatch the sink has already seen the data and DANP_FTP_STATUS_DIGEST_MISMATCH is returned.
+ *
+ * With `elide_runs` set, the sender may replace repeated-byte runs by hole records. They are passed
+ * to `hole_callback` if set, otherwise expanded into ordinary sink calls.
+ *
  * @param[in]  handle           Pointer to the initialized FTP handle.
  * @param[in]  transfer_config  Pointer to the transfer configuration structure.
  * @param[in]  callback         Sink callback function to process received data.
@@ -202,6 +426,67 @@ extern danp_ftp_status_t danp_ftp_receive(
     void *user_data
 );
 
+/**
+ * @brief Receives several files in a single batch session.
+ *
+ * This function requests all files with one command and receives them back-to-back on the same
+ * socket, so the command/response handshake is paid once per batch instead of once per file.
+ * Each file starts with a chunk flagged as first and ends with a chunk flagged as last; the sink
+ * callback is given the index of the file every chunk belongs to. Files the remote side does not
+ * have are skipped and reported as DANP_FTP_STATUS_FILE_NOT_FOUND in `file_status`.
+ *
+ * @param[in]  handle           Pointer to the initialized FTP handle.
+ * @param[in]  batch_config     Pointer to the batch configuration structure.
+ * @param[in]  callback         Batch sink callback function to process received data.
+ * @param[in]  user_data        User-defined data passed to the callback.
+ *
+ * @return Total number of bytes received on success, negative status code otherwise.
+ */
+extern danp_ftp_status_t danp_ftp_receive_batch(
+    danp_ftp_handle_t *handle,                           /* FTP handle */
+    const danp_ftp_batch_config_t *batch_config,         /* Batch configuration */
+    danp_ftp_batch_sink_cb_t callback,                   /* Batch sink callback */
+    void *user_data
+);
+
+/**
+ * @brief Lists the files available on the remote node.
+ *
+ * This function sends a LIST command and receives the manifest as a stream of data chunks, each
+ * holding one or more complete entries with file ID, size, modification stamp and checksum.
+ * `transfer_config->file_id` is an optional prefix filter and may be NULL; only the timeout is
+ * used from the remaining fields. Combine with danp_ftp_manifest_* to fetch only changed files.
+ *
+ * @param[in]  handle           Pointer to the initialized FTP handle.
+ * @param[in]  transfer_config  Pointer to the transfer configuration structure.
+ * @param[in]  callback         List callback invoked for every manifest entry.
+ * @param[in]  user_data        User-defined data passed to the callback.
+ *
+ * @return Number of manifest entries on success, negative status code otherwise.
+ */
+extern danp_ftp_status_t danp_ftp_list(
+    danp_ftp_handle_t *handle,                           /* FTP handle */
+    const danp_ftp_transfer_config_t *transfer_config,   /* Transfer configuration */
+    danp_ftp_list_cb_t callback,                         /* List callback */
+    void *user_data
+);
+
+/**
+ * @brief Checks that the remote FTP service answers on this handle.
+ *
+ * This function sends a PING command and waits for the response. It is a cheap health check for
+ * connections kept open between transfers.
+ *
+ * @param[in]  handle      Pointer to the initialized FTP handle.
+ * @param[in]  timeout_ms  Timeout in milliseconds, 0 for the default.
+ *
+ * @return Status code indicating whether the connection is usable.
+ */
+extern danp_ftp_status_t danp_ftp_ping(
+    danp_ftp_handle_t *handle,                           /* FTP handle */
+    uint32_t timeout_ms                                  /* Timeout in milliseconds */
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,401 @@
+/* danp_ftp.hpp - header-only C++20 RAII and coroutine layer over the DANP FTP API */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_HPP
+#define INC_DANP_FTP_HPP
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp.h"
+
+#if !defined(__cpp_impl_coroutine) || !defined(__cpp_concepts)
+#error "danp_ftp.hpp requires C++20 coroutines and concepts"
+#endif
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace danp::ftp
+{
+
+/* Types */
+
+/**
+ * @brief Produces the chunk of a file starting at `offset`.
+ *
+ * Same contract as danp_ftp_source_cb_t: fill at most `buffer.size()` bytes, set `more` to false
+ * after the last chunk and return the number of bytes produced or a negative status code. The
+ * callable is invoked directly from the transfer loop, without type erasure, and must not throw.
+ */
+template <class S>
+concept source = requires(S &s, std::size_t offset, std::span<std::uint8_t> buffer, bool &more) {
+    { s(offset, buffer, more) } -> std::convertible_to<danp_ftp_status_t>;
+};
+
+/**
+ * @brief Consumes the chunk of a file starting at `offset`.
+ *
+ * Same contract as danp_ftp_sink_cb_t: return a non-negative value to continue or a negative
+ * status code to abort. `data` is only valid during the call. Must not throw.
+ */
+template <class S>
+concept sink = requires(S &s, std::size_t offset, std::span<const std::uint8_t> data, bool more) {
+    { s(offset, data, more) } -> std::convertible_to<danp_ftp_status_t>;
+};
+
+namespace detail
+{
+
+struct work_archetype
+{
+    void operator()() noexcept {}
+};
+
+template <source Source>
+danp_ftp_status_t source_trampoline(
+    danp_ftp_handle_t *,
+    std::size_t offset,
+    std::uint8_t *data,
+    std::uint16_t length,
+    std::uint8_t *more,
+    void *user_data) noexcept
+{
+    bool has_more = true;
+    danp_ftp_status_t status = (*static_cast<Source *>(user_data))(
+        offset,
+        std::span<std::uint8_t>(data, length),
+        has_more);
+
+    if (more)
+    {
+        *more = has_more ? 1 : 0;
+    }
+
+    return status;
+}
+
+template <sink Sink>
+danp_ftp_status_t sink_trampoline(
+    danp_ftp_handle_t *,
+    std::size_t offset,
+    const std::uint8_t *data,
+    std::uint16_t length,
+    std::uint8_t more,
+    void *user_data) noexcept
+{
+    return (*static_cast<Sink *>(user_data))(
+        offset,
+        std::span<const std::uint8_t>(data, length),
+        more != 0);
+}
+
+template <class Progress>
+void progress_trampoline(danp_ftp_handle_t *, std::size_t bytes, void *user_data) noexcept
+{
+    (*static_cast<Progress *>(user_data))(bytes);
+}
+
+} /* namespace detail */
+
+/**
+ * @brief Anything that can run a piece of work, now or later, on some thread.
+ *
+ * Matches thread pools, event loops and strands through a one-line adapter exposing
+ * `execute(f)`. Executors are invoked once per transfer, never per chunk.
+ */
+template <class E>
+concept executor = std::copy_constructible<E> && requires(E &e, detail::work_archetype work) {
+    e.execute(std::move(work));
+};
+
+/**
+ * @brief Runs work immediately on the calling thread.
+ */
+struct inline_executor
+{
+    template <std::invocable F>
+    void execute(F &&work) const
+    {
+        std::forward<F>(work)();
+    }
+};
+
+/**
+ * @brief Runs every piece of work on a new detached thread.
+ *
+ * The simplest way to keep a coroutine thread free while transfers block; a pool adapter is the
+ * better choice for many concurrent transfers.
+ */
+struct thread_executor
+{
+    template <std::invocable F>
+    void execute(F &&work) const
+    {
+        std::thread(std::forward<F>(work)).detach();
+    }
+};
+
+/**
+ * @brief Builds a transfer configuration for a file id.
+ *
+ * The configuration points into `file_id`, which must outlive the transfers that use it.
+ */
+inline danp_ftp_transfer_config_t make_config(
+    std::string_view file_id,
+    std::uint16_t chunk_size = 0,
+    std::uint32_t timeout_ms = 0) noexcept
+{
+    danp_ftp_transfer_config_t config{};
+
+    config.file_id = reinterpret_cast<const std::uint8_t *>(file_id.data());
+    config.file_id_len = file_id.size();
+    config.chunk_size = chunk_size;
+    config.timeout_ms = timeout_ms;
+
+    return config;
+}
+
+/**
+ * @brief Owns an FTP connection to one node, deinitialized on destruction.
+ *
+ * Move-only. The C handle lives inside the object and transfers keep pointers to it, so a handle
+ * must not be moved or destroyed while a transfer on it is in flight.
+ */
+class handle
+{
+public:
+    handle() noexcept = default;
+
+    ~handle()
+    {
+        close();
+    }
+
+    handle(const handle &) = delete;
+    handle &operator=(const handle &) = delete;
+
+    handle(handle &&other) noexcept
+        : m_handle(std::exchange(other.m_handle, danp_ftp_handle_t{}))
+    {
+    }
+
+    handle &operator=(handle &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_handle = std::exchange(other.m_handle, danp_ftp_handle_t{});
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Connects to the FTP service of a node, closing any previous connection.
+     *
+     * @return Status code of danp_ftp_init().
+     */
+    danp_ftp_status_t open(std::uint16_t dst_node) noexcept
+    {
+        close();
+        return danp_ftp_init(&m_handle, dst_node);
+    }
+
+    void close() noexcept
+    {
+        danp_ftp_deinit(&m_handle);
+    }
+
+    [[nodiscard]] bool is_open() const noexcept
+    {
+        return m_handle.is_initialized;
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return is_open();
+    }
+
+    [[nodiscard]] danp_ftp_handle_t *native() noexcept
+    {
+        return &m_handle;
+    }
+
+    [[nodiscard]] danp_ftp_state_t state() const noexcept
+    {
+        return m_handle.state;
+    }
+
+    [[nodiscard]] std::size_t bytes_transferred() const noexcept
+    {
+        return m_handle.total_bytes_transferred;
+    }
+
+    /**
+     * @brief Cancels the running transfer, see danp_ftp_cancel(). Safe from any thread.
+     */
+    danp_ftp_status_t cancel() noexcept
+    {
+        return danp_ftp_cancel(&m_handle);
+    }
+
+    /**
+     * @brief Reports progress to `callback(bytes)`, see danp_ftp_set_progress().
+     *
+     * `callback` is referenced, not copied, and must outlive the transfers it observes.
+     */
+    template <std::invocable<std::size_t> Progress>
+    void set_progress(Progress &callback, std::uint32_t interval_ms) noexcept
+    {
+        danp_ftp_set_progress(
+            &m_handle,
+            &detail::progress_trampoline<Progress>,
+            interval_ms,
+            &callback);
+    }
+
+    void clear_progress() noexcept
+    {
+        danp_ftp_set_progress(&m_handle, nullptr, 0, nullptr);
+    }
+
+    /**
+     * @brief Transmits a file, blocking the calling thread. See danp_ftp_transmit().
+     */
+    template <source Source>
+    danp_ftp_status_t transmit(const danp_ftp_transfer_config_t &config, Source &src) noexcept
+    {
+        return danp_ftp_transmit(
+            &m_handle,
+            &config,
+            &detail::source_trampoline<Source>,
+            &src);
+    }
+
+    /**
+     * @brief Receives a file, blocking the calling thread. See danp_ftp_receive().
+     */
+    template <sink Sink>
+    danp_ftp_status_t receive(const danp_ftp_transfer_config_t &config, Sink &dst) noexcept
+    {
+        return danp_ftp_receive(
+            &m_handle,
+            &config,
+            &detail::sink_trampoline<Sink>,
+            &dst);
+    }
+
+private:
+    danp_ftp_handle_t m_handle{};
+};
+
+/**
+ * @brief Awaiter running one blocking transfer on an executor.
+ *
+ * The awaiting coroutine is suspended, the transfer runs on `Work` and the coroutine is resumed
+ * through `Resume` with the transfer result: bytes transferred or a negative status code. The
+ * awaiter lives in the coroutine frame, so the callable and configuration it holds stay valid for
+ * the whole transfer. Once the resume is queued the frame may already be destroyed, so both
+ * executors are invoked through copies and nothing of the awaiter is touched afterwards.
+ */
+template <class Operation, executor Work, executor Resume>
+class transfer_awaiter
+{
+public:
+    transfer_awaiter(Operation operation, Work work, Resume resume)
+        : m_operation(std::move(operation)), m_work(std::move(work)), m_resume(std::move(resume))
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting)
+    {
+        /* The frame may be gone before execute() returns, so executors run from copies */
+        Work work = m_work;
+
+        work.execute(
+            [this, awaiting]() noexcept
+            {
+                m_result = m_operation();
+
+                Resume resume = m_resume;
+                resume.execute([awaiting]() noexcept { awaiting.resume(); });
+            });
+    }
+
+    danp_ftp_status_t await_resume() const noexcept
+    {
+        return m_result;
+    }
+
+private:
+    Operation m_operation;
+    Work m_work;
+    Resume m_resume;
+    danp_ftp_status_t m_result = DANP_FTP_STATUS_ERROR;
+};
+
+/**
+ * @brief Awaitable transmit: `co_await async_transmit(h, config, source, pool)`.
+ *
+ * The source is moved into the awaiter; pass std::ref() to keep using it afterwards. Without a
+ * `resume` executor the coroutine continues on the thread that ran the transfer.
+ */
+template <source Source, executor Work, executor Resume = inline_executor>
+auto async_transmit(
+    handle &h,
+    const danp_ftp_transfer_config_t &config,
+    Source src,
+    Work work,
+    Resume resume = {})
+{
+    auto operation = [&h, config, src = std::move(src)]() mutable noexcept
+    {
+        return h.transmit(config, src);
+    };
+
+    return transfer_awaiter<decltype(operation), Work, Resume>(
+        std::move(operation),
+        std::move(work),
+        std::move(resume));
+}
+
+/**
+ * @brief Awaitable receive: `co_await async_receive(h, config, sink, pool)`.
+ *
+ * The sink is moved into the awaiter; pass std::ref() to keep using it afterwards. Without a
+ * `resume` executor the coroutine continues on the thread that ran the transfer.
+ */
+template <sink Sink, executor Work, executor Resume = inline_executor>
+auto async_receive(
+    handle &h,
+    const danp_ftp_transfer_config_t &config,
+    Sink dst,
+    Work work,
+    Resume resume = {})
+{
+    auto operation = [&h, config, dst = std::move(dst)]() mutable noexcept
+    {
+        return h.receive(config, dst);
+    };
+
+    return transfer_awaiter<decltype(operation), Work, Resume>(
+        std::move(operation),
+        std::move(work),
+        std::move(resume));
+}
+
+} /* namespace danp::ftp */
+
+#endif /* INC_DANP_FTP_HPP */
@@ -0,0 +1,170 @@
+/* danp_ftp_chunk_store.h - bounded content-addressed chunk store with LRU eviction */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_CHUNK_STORE_H
+#define INC_DANP_FTP_CHUNK_STORE_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_sha256.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define DANP_FTP_CHUNK_STORE_NONE             (0xFFFFU)
+#define DANP_FTP_CHUNK_STORE_MAX_CAPACITY     (DANP_FTP_CHUNK_STORE_NONE - 1U)
+
+/* Types */
+
+typedef struct danp_ftp_chunk_entry_s
+{
+    uint8_t hash[DANP_FTP_SHA256_SIZE];            /* SHA-256 of the chunk */
+    uint16_t length;                               /* Stored bytes, valid entries only */
+    uint16_t lru_prev;                             /* Towards most recently used */
+    uint16_t lru_next;                             /* Towards least recently used */
+    uint16_t bucket_head;                          /* First entry of the bucket with this index */
+    uint16_t bucket_next;                          /* Next entry in the same bucket */
+    bool is_used;                                  /* Entry holds a hash */
+    bool is_valid;                                 /* Entry holds the data of the hash */
+} danp_ftp_chunk_entry_t;
+
+typedef struct danp_ftp_chunk_store_stats_s
+{
+    uint32_t hits;                                 /* Lookups that found the data */
+    uint32_t misses;                               /* Lookups that did not */
+    uint32_t insertions;                           /* Chunks stored */
+    uint32_t evictions;                            /* Chunks dropped to make room */
+} danp_ftp_chunk_store_stats_t;
+
+typedef struct danp_ftp_chunk_store_s
+{
+    danp_ftp_chunk_entry_t *entries;               /* Caller-owned entry storage */
+    uint8_t *data;                                 /* Caller-owned chunk storage */
+    size_t capacity;                               /* Number of entries and chunk slots */
+    uint16_t chunk_size;                           /* Size of one chunk slot */
+    uint16_t lru_head;                             /* Most recently used entry */
+    uint16_t lru_tail;                             /* Least recently used entry */
+    size_t count;                                  /* Entries in use */
+    danp_ftp_chunk_store_stats_t stats;
+} danp_ftp_chunk_store_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a chunk store over caller-owned storage.
+ *
+ * The store indexes chunks by SHA-256 in a hash table kept inside `entries` and evicts the least
+ * recently used chunk when full. Lookups and insertions are O(1) on average.
+ *
+ * @param[out] store       Pointer to the chunk store to initialize.
+ * @param[in]  entries     Storage for `capacity` entries.
+ * @param[in]  capacity    Number of chunks, at most DANP_FTP_CHUNK_STORE_MAX_CAPACITY.
+ * @param[in]  data        Storage for `capacity * chunk_size` bytes of chunk data.
+ * @param[in]  chunk_size  Largest chunk the store accepts.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_chunk_store_init(
+    danp_ftp_chunk_store_t *store,                 /* Chunk store */
+    danp_ftp_chunk_entry_t *entries,               /* Entry storage */
+    size_t capacity,                               /* Entry storage capacity */
+    uint8_t *data,                                 /* Chunk storage */
+    uint16_t chunk_size                            /* Chunk slot size */
+);
+
+/**
+ * @brief Looks up a chunk by hash and marks it as recently used.
+ *
+ * @param[in] store  Pointer to the chunk store.
+ * @param[in] hash   SHA-256 of the chunk.
+ *
+ * @return Entry index, or DANP_FTP_STATUS_FILE_NOT_FOUND if the data is not stored.
+ */
+extern danp_ftp_status_t danp_ftp_chunk_store_find(
+    danp_ftp_chunk_store_t *store,                 /* Chunk store */
+    const uint8_t *hash                            /* Chunk hash */
+);
+
+/**
+ * @brief Reserves an entry for a hash whose data will be filled in later.
+ *
+ * Returns the existing entry if the hash is known, otherwise takes a free entry or evicts the
+ * least recently used one. Either way the entry becomes the most recently used, so it survives
+ * the next `capacity - 1` reservations.
+ *
+ * @param[in] store  Pointer to the chunk store.
+ * @param[in] hash   SHA-256 of the chunk.
+ *
+ * @return Entry index.
+ */
+extern danp_ftp_status_t danp_ftp_chunk_store_reserve(
+    danp_ftp_chunk_store_t *store,                 /* Chunk store */
+    const uint8_t *hash                            /* Chunk hash */
+);
+
+/**
+ * @brief Stores the data of a reserved entry.
+ *
+ * The caller is responsible for `data` matching the hash of the entry.
+ *
+ * @param[in] store   Pointer to the chunk store.
+ * @param[in] index   Entry index from danp_ftp_chunk_store_reserve().
+ * @param[in] data    Chunk data.
+ * @param[in] length  Chunk size, at most the chunk slot size.
+ *
+ * @return Status code indicating the result of the operation.
+ */
+extern danp_ftp_status_t danp_ftp_chunk_store_fill(
+    danp_ftp_chunk_store_t *store,                 /* Chunk store */
+    size_t index,                                  /* Entry index */
+    const uint8_t *data,                           /* Chunk data */
+    uint16_t length                                /* Chunk size */
+);
+
+/**
+ * @brief Hashes and stores a chunk.
+ *
+ * @param[in]  store   Pointer to the chunk store.
+ * @param[in]  data    Chunk data.
+ * @param[in]  length  Chunk size, at most the chunk slot size.
+ * @param[out] hash    Buffer of DANP_FTP_SHA256_SIZE bytes for the hash, may be NULL.
+ *
+ * @return Entry index or negative status code.
+ */
+extern danp_ftp_status_t danp_ftp_chunk_store_insert(
+    danp_ftp_chunk_store_t *store,                 /* Chunk store */
+    const uint8_t *data,                           /* Chunk data */
+    uint16_t length,                               /* Chunk size */
+    uint8_t *hash                                  /* Chunk hash */
+);
+
+/**
+ * @brief Returns the data of a valid entry.
+ *
+ * @param[in]  store   Pointer to the chunk store.
+ * @param[in]  index   Entry index.
+ * @param[out] length  Pointer to store the chunk size.
+ *
+ * @return Pointer to the chunk data, or NULL if the entry holds no data.
+ */
+extern const uint8_t *danp_ftp_chunk_store_data(
+    const danp_ftp_chunk_store_t *store,           /* Chunk store */
+    size_t index,                                  /* Entry index */
+    uint16_t *length                               /* Chunk size */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_CHUNK_STORE_H */
@@ -0,0 +1,145 @@
+/* danp_ftp_coalesce.h - sink wrapper coalescing chunks into large aligned block writes */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_COALESCE_H
+#define INC_DANP_FTP_COALESCE_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define DANP_FTP_COALESCE_FLAG_NONE           (0x00)
+#define DANP_FTP_COALESCE_FLAG_SYNC_ON_FINAL  (0x01)
+
+/* Types */
+
+/**
+ * @brief Writes one block to storage.
+ *
+ * @param user_data  Writer context.
+ * @param offset     File offset of the block, a multiple of the block size except for the tail.
+ * @param data       Block data.
+ * @param length     Block length, the block size except for the final block.
+ *
+ * @return Number of bytes written (must equal `length`) or negative status code.
+ */
+typedef danp_ftp_status_t (*danp_ftp_block_write_cb_t)(
+    void *user_data,
+    size_t offset,
+    const uint8_t *data,
+    size_t length
+);
+
+/**
+ * @brief Flushes written blocks to stable storage.
+ *
+ * @param user_data Writer context.
+ *
+ * @return Status code.
+ */
+typedef danp_ftp_status_t (*danp_ftp_block_sync_cb_t)(
+    void *user_data
+);
+
+typedef struct danp_ftp_coalesce_stats_s
+{
+    uint32_t chunks;                               /* Chunks received from the transfer */
+    uint32_t writes;                               /* Block writes issued */
+    uint32_t syncs;                                /* Syncs issued */
+    uint64_t bytes_written;                        /* Bytes handed to the writer */
+} danp_ftp_coalesce_stats_t;
+
+typedef struct danp_ftp_coalesce_sink_s
+{
+    danp_ftp_block_write_cb_t write;               /* Block writer */
+    danp_ftp_block_sync_cb_t sync;                 /* Optional sync, used with SYNC_ON_FINAL */
+    void *writer_data;                             /* Writer context */
+    uint8_t *buffer;                               /* Caller-owned block buffer */
+    size_t block_size;                             /* Buffer size */
+    size_t base_offset;                            /* File offset of buffer[0] */
+    size_t fill;                                   /* Bytes held in the buffer */
+    uint8_t flags;                                 /* DANP_FTP_COALESCE_FLAG_* */
+    danp_ftp_coalesce_stats_t stats;
+} danp_ftp_coalesce_sink_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a coalescing sink.
+ *
+ * Chunks passed to danp_ftp_coalesce_sink_cb() are gathered in `buffer` and written as whole
+ * blocks of `block_size` bytes at block-aligned offsets. The final chunk (`more == 0`) flushes the
+ * partial tail block and, with DANP_FTP_COALESCE_FLAG_SYNC_ON_FINAL, syncs once.
+ *
+ * Durability: the ACK of a chunk only means the chunk is buffered. Up to one block of
+ * acknowledged data is held in memory and lost if the receiver fails mid-transfer, which then has
+ * to be restarted. The file is complete on storage when the final chunk has been accepted, and
+ * durable only if SYNC_ON_FINAL is set, because the final ACK is sent after the sync returns.
+ *
+ * For O_DIRECT writers, `buffer` and `block_size` must satisfy the device alignment.
+ *
+ * @param[out] sink         Pointer to the sink to initialize.
+ * @param[in]  buffer       Block buffer.
+ * @param[in]  block_size   Size of the block buffer.
+ * @param[in]  write        Block writer callback.
+ * @param[in]  sync         Sync callback, may be NULL.
+ * @param[in]  writer_data  Context passed to the writer callbacks.
+ * @param[in]  flags        DANP_FTP_COALESCE_FLAG_* options.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_coalesce_sink_init(
+    danp_ftp_coalesce_sink_t *sink,                /* Coalescing sink */
+    uint8_t *buffer,                               /* Block buffer */
+    size_t block_size,                             /* Block buffer size */
+    danp_ftp_block_write_cb_t write,               /* Block writer */
+    danp_ftp_block_sync_cb_t sync,                 /* Sync callback */
+    void *writer_data,                             /* Writer context */
+    uint8_t flags                                  /* Options */
+);
+
+/**
+ * @brief Sink callback buffering chunks into blocks.
+ *
+ * `user_data` is a danp_ftp_coalesce_sink_t. A chunk that does not continue the buffered data
+ * flushes the buffer first, so out-of-order data is still written at the right offset.
+ */
+extern danp_ftp_status_t danp_ftp_coalesce_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data
+);
+
+/**
+ * @brief Writes out buffered data without waiting for the final chunk.
+ *
+ * Use after a failed or cancelled transfer to keep the received prefix.
+ *
+ * @param[in] sink Pointer to the sink.
+ *
+ * @return Status code indicating the result of the flush.
+ */
+extern danp_ftp_status_t danp_ftp_coalesce_sink_flush(
+    danp_ftp_coalesce_sink_t *sink                 /* Coalescing sink */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_COALESCE_H */
@@ -0,0 +1,93 @@
+/* danp_ftp_dedup.h - deduplicated transfers over a content-addressed chunk store */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_DEDUP_H
+#define INC_DANP_FTP_DEDUP_H
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_chunk_store.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_DEDUP_WINDOW
+#define CONFIG_DANP_FTP_DEDUP_WINDOW          (16)
+#endif
+
+/* Definitions */
+
+/* Chunks advertised per hash list, also limited by how many hashes fit in one payload */
+#define DANP_FTP_DEDUP_WINDOW                 (CONFIG_DANP_FTP_DEDUP_WINDOW)
+
+/* Types */
+
+
+/* External Declarations */
+
+/**
+ * @brief Transmits data, sending only the chunks the receiver does not already hold.
+ *
+ * The source is read in windows of up to DANP_FTP_DEDUP_WINDOW chunks. Each chunk is hashed with
+ * SHA-256 and kept in `store`, then the hashes of the window are advertised in one packet. The
+ * receiver answers with a bitmap of the chunks missing from its own store and only those chunks
+ * are sent. Repeated content, both within a file and across transfers, costs 32 bytes per chunk
+ * instead of the chunk itself.
+ *
+ * `store` must hold at least one window and its chunk slots must fit `chunk_size`. The chunk size
+ * should match the one the receiver's store was filled with, or nothing will be found there.
+ *
+ * @param[in]  handle           Pointer to the initialized FTP handle.
+ * @param[in]  transfer_config  Pointer to the transfer configuration structure.
+ * @param[in]  store            Chunk store holding the window being sent.
+ * @param[in]  callback         Source callback function to provide data.
+ * @param[in]  user_data        User-defined data passed to the callback.
+ *
+ * @return Number of bytes of the file on success, negative status code otherwise.
+ */
+extern danp_ftp_status_t danp_ftp_transmit_dedup(
+    danp_ftp_handle_t *handle,                           /* FTP handle */
+    const danp_ftp_transfer_config_t *transfer_config,   /* Transfer configuration */
+    danp_ftp_chunk_store_t *store,                       /* Chunk store */
+    danp_ftp_source_cb_t callback,                       /* Source callback */
+    void *user_data
+);
+
+/**
+ * @brief Receives data, fetching only the chunks missing from a local chunk store.
+ *
+ * The counterpart of danp_ftp_transmit_dedup() for reads. For every advertised window the chunks
+ * found in `store` are reused and the others requested; received chunks are checked against their
+ * advertised hash before they are stored. The sink sees the whole file in order, as with
+ * danp_ftp_receive(), with data pointing into the store.
+ *
+ * `store` must hold at least one window. Its chunk slot size is sent to the peer as the chunk
+ * size to use, so the same store should be kept across transfers for repeated content to hit.
+ *
+ * @param[in]  handle           Pointer to the initialized FTP handle.
+ * @param[in]  transfer_config  Pointer to the transfer configuration structure.
+ * @param[in]  store            Chunk store to reuse and fill.
+ * @param[in]  callback         Sink callback function to process received data.
+ * @param[in]  user_data        User-defined data passed to the callback.
+ *
+ * @return Number of bytes of the file on success, negative status code otherwise.
+ */
+extern danp_ftp_status_t danp_ftp_receive_dedup(
+    danp_ftp_handle_t *handle,                           /* FTP handle */
+    const danp_ftp_transfer_config_t *transfer_config,   /* Transfer configuration */
+    danp_ftp_chunk_store_t *store,                       /* Chunk store */
+    danp_ftp_sink_cb_t callback,                         /* Sink callback */
+    void *user_data
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_DEDUP_H */
@@ -0,0 +1,235 @@
+/* danp_ftp_file.h - ready-made file source and sink adapters for POSIX hosts */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_FILE_H
+#define INC_DANP_FTP_FILE_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_coalesce.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define DANP_FTP_FILE_DEFAULT_READAHEAD       (256U * 1024U)
+#define DANP_FTP_FILE_DIRECT_ALIGNMENT        (4096U)
+
+/* Types */
+
+typedef struct danp_ftp_fd_file_s
+{
+    int fd;                                        /* Open file descriptor */
+    size_t size;                                   /* File size, read sources only */
+    bool is_direct;                                /* Opened with O_DIRECT */
+    uint32_t direct_writes;                        /* Block writes that bypassed the page cache */
+    uint32_t buffered_writes;                      /* Block writes that went through it */
+} danp_ftp_fd_file_t;
+
+typedef struct danp_ftp_mmap_source_s
+{
+    int fd;
+    const uint8_t *data;                           /* Read-only mapping of the whole file */
+    size_t size;                                   /* File size in bytes */
+    size_t readahead;                              /* Readahead window in bytes */
+    size_t advised_end;                            /* End of the range already advised */
+} danp_ftp_mmap_source_t;
+
+typedef struct danp_ftp_mmap_sink_s
+{
+    int fd;
+    uint8_t *data;                                 /* Shared writable mapping */
+    size_t capacity;                               /* Mapped and allocated size */
+    size_t size;                                   /* Highest byte written so far */
+} danp_ftp_mmap_sink_t;
+
+/* External Declarations */
+
+/**
+ * @brief Opens a file for use as a transmit source with danp_ftp_fd_source_cb().
+ *
+ * The size is taken once at open so that the source flags the last chunk even when the file
+ * size is a multiple of the chunk size. Close `fd` when the transfer is done.
+ *
+ * @param[out] file  Pointer to the file to open.
+ * @param[in]  path  Path of the file to send.
+ *
+ * @return Status code, DANP_FTP_STATUS_FILE_NOT_FOUND if the file cannot be opened.
+ */
+extern danp_ftp_status_t danp_ftp_fd_open_source(
+    danp_ftp_fd_file_t *file,                      /* File */
+    const char *path                               /* File path */
+);
+
+/**
+ * @brief Source callback reading chunks with pread().
+ *
+ * Baseline adapter: one syscall and one copy per chunk. `user_data` is a danp_ftp_fd_file_t
+ * opened with danp_ftp_fd_open_source().
+ */
+extern danp_ftp_status_t danp_ftp_fd_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data
+);
+
+/**
+ * @brief Sink callback writing chunks with pwrite().
+ *
+ * Baseline adapter: one syscall and one copy per chunk. `user_data` is a danp_ftp_fd_file_t.
+ */
+extern danp_ftp_status_t danp_ftp_fd_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data
+);
+
+/**
+ * @brief Creates a file for block writes, bypassing the page cache where possible.
+ *
+ * On Linux the file is opened with O_DIRECT when `direct` is set and the filesystem supports it;
+ * elsewhere, or if O_DIRECT is refused, it falls back to buffered I/O. Pair with the coalescing
+ * sink, whose buffer must then be aligned to DANP_FTP_FILE_DIRECT_ALIGNMENT.
+ *
+ * @param[out] file    Pointer to the file to open.
+ * @param[in]  path    Path of the file to create or truncate.
+ * @param[in]  direct  Request O_DIRECT.
+ *
+ * @return Status code indicating the result of the operation.
+ */
+extern danp_ftp_status_t danp_ftp_fd_open_block_writer(
+    danp_ftp_fd_file_t *file,                      /* File */
+    const char *path,                              /* File path */
+    bool direct                                    /* Request O_DIRECT */
+);
+
+/**
+ * @brief Block writer for danp_ftp_coalesce_sink_t using pwrite().
+ *
+ * An unaligned block (usually the tail) is written through the page cache with O_DIRECT cleared
+ * for that one call. `direct_writes` and `buffered_writes` of the danp_ftp_fd_file_t passed as
+ * `user_data` count how the blocks were written.
+ */
+extern danp_ftp_status_t danp_ftp_fd_block_write(
+    void *user_data,
+    size_t offset,
+    const uint8_t *data,
+    size_t length
+);
+
+/**
+ * @brief Block sync for danp_ftp_coalesce_sink_t using fdatasync().
+ *
+ * `user_data` is a danp_ftp_fd_file_t.
+ */
+extern danp_ftp_status_t danp_ftp_fd_block_sync(
+    void *user_data
+);
+
+/**
+ * @brief Maps a file for use as a transmit source.
+ *
+ * The file is mapped read-only and advised as sequential; pages are prefetched in windows of
+ * `readahead` bytes ahead of the transfer offset.
+ *
+ * @param[out] source     Pointer to the source to open.
+ * @param[in]  path       Path of the file to send.
+ * @param[in]  readahead  Readahead window in bytes, 0 for DANP_FTP_FILE_DEFAULT_READAHEAD.
+ *
+ * @return Status code, DANP_FTP_STATUS_FILE_NOT_FOUND if the file cannot be opened.
+ */
+extern danp_ftp_status_t danp_ftp_mmap_source_open(
+    danp_ftp_mmap_source_t *source,                /* Mapped source */
+    const char *path,                              /* File path */
+    size_t readahead                               /* Readahead window */
+);
+
+/**
+ * @brief Source callback copying slices out of the mapping by offset.
+ *
+ * No syscall on the data path. `user_data` is a danp_ftp_mmap_source_t.
+ */
+extern danp_ftp_status_t danp_ftp_mmap_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data
+);
+
+/**
+ * @brief Unmaps and closes a mapped source.
+ *
+ * @param[in] source Pointer to the source.
+ */
+extern void danp_ftp_mmap_source_close(
+    danp_ftp_mmap_source_t *source                 /* Mapped source */
+);
+
+/**
+ * @brief Creates a file and maps it as a receive sink.
+ *
+ * `expected_size` bytes are preallocated and mapped up front so that chunks are plain memory
+ * copies; the mapping grows by doubling if more data arrives. The file is truncated to the
+ * received size on close.
+ *
+ * @param[out] sink           Pointer to the sink to open.
+ * @param[in]  path           Path of the file to create or truncate.
+ * @param[in]  expected_size  Expected file size in bytes, e.g. from a manifest entry.
+ *
+ * @return Status code indicating the result of the operation.
+ */
+extern danp_ftp_status_t danp_ftp_mmap_sink_open(
+    danp_ftp_mmap_sink_t *sink,                    /* Mapped sink */
+    const char *path,                              /* File path */
+    size_t expected_size                           /* Preallocated size */
+);
+
+/**
+ * @brief Sink callback copying chunks into the mapping at their offset.
+ *
+ * `user_data` is a danp_ftp_mmap_sink_t.
+ */
+extern danp_ftp_status_t danp_ftp_mmap_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data
+);
+
+/**
+ * @brief Unmaps a sink, trims the file to the received size and closes it.
+ *
+ * @param[in] sink  Pointer to the sink.
+ * @param[in] sync  Flush the data to stable storage before closing.
+ *
+ * @return Status code indicating the result of the operation.
+ */
+extern danp_ftp_status_t danp_ftp_mmap_sink_close(
+    danp_ftp_mmap_sink_t *sink,                    /* Mapped sink */
+    bool sync                                      /* Flush to storage */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_FILE_H */
@@ -0,0 +1,97 @@
+/* danp_ftp_manifest.h - client side cache of remote file manifests */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_MANIFEST_H
+#define INC_DANP_FTP_MANIFEST_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+typedef struct danp_ftp_manifest_s
+{
+    danp_ftp_manifest_entry_t *entries;            /* Caller-owned entry storage */
+    size_t capacity;                               /* Number of entries in storage */
+    size_t count;                                  /* Number of cached entries */
+} danp_ftp_manifest_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a manifest cache over caller-owned storage.
+ *
+ * @param[out] manifest  Pointer to the manifest cache to initialize.
+ * @param[in]  entries   Storage for cached entries.
+ * @param[in]  capacity  Number of entries in `entries`.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_manifest_init(
+    danp_ftp_manifest_t *manifest,                 /* Manifest cache */
+    danp_ftp_manifest_entry_t *entries,            /* Entry storage */
+    size_t capacity                                /* Entry storage capacity */
+);
+
+/**
+ * @brief Looks up a cached entry by file ID.
+ *
+ * @param[in]  manifest     Pointer to the manifest cache.
+ * @param[in]  file_id      File name/id.
+ * @param[in]  file_id_len  File name/id len.
+ *
+ * @return Pointer to the cached entry, or NULL if the file is not cached.
+ */
+extern danp_ftp_manifest_entry_t *danp_ftp_manifest_find(
+    const danp_ftp_manifest_t *manifest,           /* Manifest cache */
+    const uint8_t *file_id,                        /* File name/id */
+    size_t file_id_len                             /* File name/id len */
+);
+
+/**
+ * @brief Checks whether a remote entry is new or differs from the cached one.
+ *
+ * @param[in]  manifest  Pointer to the manifest cache.
+ * @param[in]  entry     Remote manifest entry, typically from danp_ftp_list().
+ *
+ * @return true if the file is not cached or its size, stamp or checksum changed.
+ */
+extern bool danp_ftp_manifest_is_changed(
+    const danp_ftp_manifest_t *manifest,           /* Manifest cache */
+    const danp_ftp_manifest_entry_t *entry         /* Remote entry */
+);
+
+/**
+ * @brief Inserts or replaces a cached entry.
+ *
+ * Call this once the file has been fetched successfully so the next sync skips it.
+ *
+ * @param[in]  manifest  Pointer to the manifest cache.
+ * @param[in]  entry     Entry to store.
+ *
+ * @return Status code, DANP_FTP_STATUS_ERROR if the cache is full.
+ */
+extern danp_ftp_status_t danp_ftp_manifest_update(
+    danp_ftp_manifest_t *manifest,                 /* Manifest cache */
+    const danp_ftp_manifest_entry_t *entry         /* Entry to store */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_MANIFEST_H */
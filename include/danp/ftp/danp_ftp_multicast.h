@@ -0,0 +1,80 @@
+/* danp_ftp_multicast.h - one-to-many file distribution with NACK based repair */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_MULTICAST_H
+#define INC_DANP_FTP_MULTICAST_H
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define DANP_FTP_MULTICAST_MAX_CHUNKS         (65535U)
+
+/* Bytes of missing-chunk bitmap needed for a file */
+#define DANP_FTP_MULTICAST_BITMAP_SIZE(file_size, chunk_size) \
+    (((((file_size) + (chunk_size) - 1U) / (chunk_size)) + 7U) / 8U)
+
+/* Types */
+
+typedef struct danp_ftp_multicast_group_s
+{
+    danp_ftp_handle_t *members;                    /* Initialized handles, one per receiver */
+    size_t member_count;                           /* Number of receivers */
+    danp_ftp_handle_t *channel;                    /* Optional handle reaching all receivers */
+} danp_ftp_multicast_group_t;
+
+typedef struct danp_ftp_multicast_config_s
+{
+    const uint8_t *file_id;                        /* File name/id */
+    size_t file_id_len;                            /* File name/id len */
+    size_t file_size;                              /* File size in bytes */
+    uint16_t chunk_size;                           /* Chunk size in bytes, must not be 0 */
+    uint32_t timeout_ms;                           /* Timeout in milliseconds */
+    uint8_t max_rounds;                            /* Maximum number of repair rounds */
+    uint8_t *missing_bitmap;                       /* Workspace for the union of missing chunks */
+    size_t bitmap_size;                            /* See DANP_FTP_MULTICAST_BITMAP_SIZE */
+    danp_ftp_status_t *member_status;              /* Optional per-member result */
+} danp_ftp_multicast_config_t;
+
+/* External Declarations */
+
+/**
+ * @brief Distributes one file to a group of receivers.
+ *
+ * Every receiver is asked to accept the file, then each chunk is sent once without waiting for
+ * per-chunk ACKs: on `channel` when the group has one (e.g. a broadcast capable link), otherwise
+ * on every member handle in turn. Afterwards each receiver reports a bitmap of missing chunks and
+ * only the union of missing chunks is sent again, for at most `max_rounds` repair rounds. The
+ * source callback must be able to produce any chunk by offset. Receivers that reject the request,
+ * stop answering or still miss data after the last round end in DANP_FTP_STATE_ERROR.
+ *
+ * @param[in]  group      Pointer to the receiver group.
+ * @param[in]  config     Pointer to the multicast configuration structure.
+ * @param[in]  callback   Source callback function to provide data.
+ * @param[in]  user_data  User-defined data passed to the callback.
+ *
+ * @return Number of receivers that hold the complete file, or negative status code.
+ */
+extern danp_ftp_status_t danp_ftp_multicast_transmit(
+    danp_ftp_multicast_group_t *group,                   /* Receiver group */
+    const danp_ftp_multicast_config_t *config,           /* Multicast configuration */
+    danp_ftp_source_cb_t callback,                       /* Source callback */
+    void *user_data
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_MULTICAST_H */
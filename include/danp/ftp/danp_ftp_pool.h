@@ -0,0 +1,154 @@
+/* danp_ftp_pool.h - per-node pool of warm FTP connections */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_POOL_H
+#define INC_DANP_FTP_POOL_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_POOL_SIZE
+#define CONFIG_DANP_FTP_POOL_SIZE             (4)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_POOL_SIZE                    (CONFIG_DANP_FTP_POOL_SIZE)
+
+/* Types */
+
+typedef struct danp_ftp_pool_config_s
+{
+    uint32_t idle_timeout_ms;                      /* Close connections idle longer, 0 = never */
+    uint32_t health_check_ms;                      /* Ping connections idle longer, 0 = never */
+    uint32_t timeout_ms;                           /* Health check timeout in milliseconds */
+} danp_ftp_pool_config_t;
+
+typedef struct danp_ftp_pool_stats_s
+{
+    uint32_t connects;                             /* New connections opened */
+    uint32_t reuses;                               /* Handles served from a warm connection */
+    uint32_t evictions;                            /* Idle connections closed by timeout or LRU */
+    uint32_t health_check_failures;                /* Warm connections that failed a ping */
+    uint64_t connect_time_us;                      /* Total time spent connecting */
+    uint64_t saved_time_us;                        /* Estimated connect time saved by reuse */
+} danp_ftp_pool_stats_t;
+
+typedef struct danp_ftp_pool_entry_s
+{
+    danp_socket_t *socket;
+    uint16_t dst_node;
+    uint64_t last_used_us;
+    bool in_use;
+} danp_ftp_pool_entry_t;
+
+typedef struct danp_ftp_pool_s
+{
+    danp_ftp_pool_entry_t entries[DANP_FTP_POOL_SIZE];
+    danp_ftp_pool_config_t config;
+    danp_ftp_pool_stats_t stats;
+    danp_ftp_mutex_t lock;
+    bool is_initialized;
+} danp_ftp_pool_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a connection pool.
+ *
+ * @param[out] pool    Pointer to the pool to initialize.
+ * @param[in]  config  Pointer to the pool configuration, NULL for defaults.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_pool_init(
+    danp_ftp_pool_t *pool,                         /* Connection pool */
+    const danp_ftp_pool_config_t *config           /* Pool configuration */
+);
+
+/**
+ * @brief Closes all idle connections and deinitializes the pool.
+ *
+ * Handles still acquired from the pool must be released before calling this function.
+ *
+ * @param[in] pool Pointer to the pool.
+ */
+extern void danp_ftp_pool_deinit(
+    danp_ftp_pool_t *pool                          /* Connection pool */
+);
+
+/**
+ * @brief Initializes an FTP handle from the pool.
+ *
+ * A warm connection to `dst_node` is reused when available, otherwise a new connection is
+ * opened. Connections idle longer than `health_check_ms` are pinged before they are handed out.
+ * When every slot holds a connection, the least recently used idle one is closed to make room
+ * for the new one. The handle must be returned with danp_ftp_pool_release() instead of
+ * danp_ftp_deinit().
+ *
+ * @param[in]  pool      Pointer to the pool.
+ * @param[out] handle    Pointer to the FTP handle to initialize.
+ * @param[in]  dst_node  Destination node ID.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_pool_acquire(
+    danp_ftp_pool_t *pool,                         /* Connection pool */
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    uint16_t dst_node                              /* Destination node ID */
+);
+
+/**
+ * @brief Returns the connection of an FTP handle to the pool.
+ *
+ * The connection is kept warm for the next acquire unless the handle is in the error state,
+ * in which case it is closed. The handle is deinitialized either way.
+ *
+ * @param[in] pool    Pointer to the pool.
+ * @param[in] handle  Pointer to the FTP handle.
+ */
+extern void danp_ftp_pool_release(
+    danp_ftp_pool_t *pool,                         /* Connection pool */
+    danp_ftp_handle_t *handle                      /* FTP handle */
+);
+
+/**
+ * @brief Closes idle connections that exceeded the idle timeout.
+ *
+ * Call periodically to release connections of nodes that are no longer synced.
+ *
+ * @param[in] pool Pointer to the pool.
+ *
+ * @return Number of connections closed.
+ */
+extern size_t danp_ftp_pool_prune(
+    danp_ftp_pool_t *pool                          /* Connection pool */
+);
+
+/**
+ * @brief Reads the pool statistics.
+ *
+ * @param[in]  pool   Pointer to the pool.
+ * @param[out] stats  Pointer to store the statistics.
+ */
+extern void danp_ftp_pool_get_stats(
+    danp_ftp_pool_t *pool,                         /* Connection pool */
+    danp_ftp_pool_stats_t *stats                   /* Statistics */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_POOL_H */
@@ -0,0 +1,137 @@
+/* danp_ftp_port.h - operating system abstraction used by DANP FTP */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_PORT_H
+#define INC_DANP_FTP_PORT_H
+
+/* Includes */
+
+#include <stdint.h>
+
+#if defined(__ZEPHYR__)
+#include <zephyr/kernel.h>
+#else
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+#if defined(__ZEPHYR__)
+typedef struct k_mutex danp_ftp_mutex_t;
+typedef struct k_condvar danp_ftp_cond_t;
+#else
+typedef pthread_mutex_t danp_ftp_mutex_t;
+typedef pthread_cond_t danp_ftp_cond_t;
+#endif
+
+/* External Declarations */
+
+/**
+ * @brief Returns a monotonic timestamp.
+ *
+ * @return Time in microseconds since an unspecified starting point.
+ */
+extern uint64_t danp_ftp_port_time_us(void);
+
+/**
+ * @brief Suspends the calling thread.
+ *
+ * @param[in] duration_us Time to sleep in microseconds.
+ */
+extern void danp_ftp_port_sleep_us(
+    uint32_t duration_us                           /* Sleep duration */
+);
+
+/**
+ * @brief Initializes a mutex.
+ *
+ * @param[out] mutex Pointer to the mutex to initialize.
+ */
+extern void danp_ftp_port_mutex_init(
+    danp_ftp_mutex_t *mutex                        /* Mutex */
+);
+
+/**
+ * @brief Releases the resources of a mutex.
+ *
+ * @param[in] mutex Pointer to the mutex.
+ */
+extern void danp_ftp_port_mutex_destroy(
+    danp_ftp_mutex_t *mutex                        /* Mutex */
+);
+
+/**
+ * @brief Locks a mutex, blocking until it is available.
+ *
+ * @param[in] mutex Pointer to the mutex.
+ */
+extern void danp_ftp_port_mutex_lock(
+    danp_ftp_mutex_t *mutex                        /* Mutex */
+);
+
+/**
+ * @brief Unlocks a mutex.
+ *
+ * @param[in] mutex Pointer to the mutex.
+ */
+extern void danp_ftp_port_mutex_unlock(
+    danp_ftp_mutex_t *mutex                        /* Mutex */
+);
+
+/**
+ * @brief Initializes a condition variable.
+ *
+ * @param[out] cond Pointer to the condition variable to initialize.
+ */
+extern void danp_ftp_port_cond_init(
+    danp_ftp_cond_t *cond                          /* Condition variable */
+);
+
+/**
+ * @brief Releases the resources of a condition variable.
+ *
+ * @param[in] cond Pointer to the condition variable.
+ */
+extern void danp_ftp_port_cond_destroy(
+    danp_ftp_cond_t *cond                          /* Condition variable */
+);
+
+/**
+ * @brief Atomically unlocks a mutex and waits for the condition to be signalled.
+ *
+ * The mutex is locked again when the function returns. Spurious wakeups are possible.
+ *
+ * @param[in] cond   Pointer to the condition variable.
+ * @param[in] mutex  Pointer to the locked mutex.
+ */
+extern void danp_ftp_port_cond_wait(
+    danp_ftp_cond_t *cond,                         /* Condition variable */
+    danp_ftp_mutex_t *mutex                        /* Locked mutex */
+);
+
+/**
+ * @brief Wakes all threads waiting on a condition variable.
+ *
+ * @param[in] cond Pointer to the condition variable.
+ */
+extern void danp_ftp_port_cond_broadcast(
+    danp_ftp_cond_t *cond                          /* Condition variable */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_PORT_H */
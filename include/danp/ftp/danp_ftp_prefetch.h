@@ -0,0 +1,157 @@
+/* danp_ftp_prefetch.h - read-ahead stage running the source callback on a worker thread */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_PREFETCH_H
+#define INC_DANP_FTP_PREFETCH_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_PREFETCH_DEPTH
+#define CONFIG_DANP_FTP_PREFETCH_DEPTH        (4)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_PREFETCH_DEPTH               (CONFIG_DANP_FTP_PREFETCH_DEPTH)
+
+/* Types */
+
+typedef struct danp_ftp_prefetch_slot_s
+{
+    uint8_t data[DANP_FTP_MAX_CHUNK_SIZE];
+    danp_ftp_status_t length;                      /* Source result for this chunk */
+    size_t offset;                                 /* Offset the chunk was read from */
+    uint8_t more;                                  /* Source `more` output */
+    uint64_t read_time_us;                         /* Time the source took for this chunk */
+} danp_ftp_prefetch_slot_t;
+
+typedef struct danp_ftp_prefetch_stats_s
+{
+    uint32_t chunks;                               /* Chunks handed to the transfer */
+    uint64_t read_time_us;                         /* Time spent in the source callback */
+    uint64_t used_read_time_us;                    /* Source time of the chunks handed out */
+    uint64_t wait_time_us;                         /* Time the transfer waited for a chunk */
+    uint64_t hidden_time_us;                       /* Source time overlapped with network waits */
+} danp_ftp_prefetch_stats_t;
+
+typedef struct danp_ftp_prefetch_s
+{
+    danp_ftp_prefetch_slot_t slots[DANP_FTP_PREFETCH_DEPTH];
+    danp_ftp_source_cb_t source;                   /* Wrapped source callback */
+    void *source_data;                             /* Wrapped source user data */
+    danp_ftp_handle_t *handle;                     /* Handle passed to the wrapped source */
+    uint16_t chunk_size;                           /* Bytes requested per chunk */
+    size_t next_offset;                            /* Offset of the next chunk to read */
+    size_t head;                                   /* Next slot to hand out */
+    size_t count;                                  /* Filled slots */
+    bool is_finished;                              /* Source reported end of data or an error */
+    bool is_stopped;                               /* Stop requested */
+    danp_ftp_prefetch_stats_t stats;
+    danp_ftp_mutex_t lock;
+    danp_ftp_cond_t changed;
+} danp_ftp_prefetch_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a prefetch stage in front of a source callback.
+ *
+ * Start danp_ftp_prefetch_run() on a worker thread, then pass danp_ftp_prefetch_source_cb() with
+ * the prefetch stage as user data to danp_ftp_transmit(). The worker keeps up to
+ * DANP_FTP_PREFETCH_DEPTH chunks read ahead, so a slow source read overlaps with the wait for the
+ * previous chunk's ACK. The transfer must use `chunk_size` as its chunk size.
+ *
+ * @param[out] prefetch     Pointer to the prefetch stage to initialize.
+ * @param[in]  handle       Handle passed to the wrapped source callback.
+ * @param[in]  chunk_size   Chunk size of the transfer.
+ * @param[in]  source       Wrapped source callback.
+ * @param[in]  source_data  User data of the wrapped source callback.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_prefetch_init(
+    danp_ftp_prefetch_t *prefetch,                 /* Prefetch stage */
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    uint16_t chunk_size,                           /* Chunk size */
+    danp_ftp_source_cb_t source,                   /* Wrapped source callback */
+    void *source_data                              /* Wrapped source user data */
+);
+
+/**
+ * @brief Runs the prefetch worker until the source is exhausted or the stage is stopped.
+ *
+ * Call from a dedicated thread; returns when the last chunk has been read, when the source
+ * fails or after danp_ftp_prefetch_stop().
+ *
+ * @param[in] prefetch Pointer to the prefetch stage.
+ */
+extern void danp_ftp_prefetch_run(
+    danp_ftp_prefetch_t *prefetch                  /* Prefetch stage */
+);
+
+/**
+ * @brief Source callback handing out prefetched chunks in order.
+ *
+ * `user_data` is a danp_ftp_prefetch_t. Blocks only if the worker has not read the chunk yet.
+ */
+extern danp_ftp_status_t danp_ftp_prefetch_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data
+);
+
+/**
+ * @brief Stops the worker, e.g. after the transfer failed.
+ *
+ * @param[in] prefetch Pointer to the prefetch stage.
+ */
+extern void danp_ftp_prefetch_stop(
+    danp_ftp_prefetch_t *prefetch                  /* Prefetch stage */
+);
+
+/**
+ * @brief Reads the prefetch statistics.
+ *
+ * `hidden_time_us / chunks` is the source latency removed from every chunk. It only counts the
+ * chunks the transfer took: reads still queued, or left behind by a failed transfer, are in
+ * `read_time_us` but not in `used_read_time_us`.
+ *
+ * @param[in]  prefetch  Pointer to the prefetch stage.
+ * @param[out] stats     Pointer to store the statistics.
+ */
+extern void danp_ftp_prefetch_get_stats(
+    danp_ftp_prefetch_t *prefetch,                 /* Prefetch stage */
+    danp_ftp_prefetch_stats_t *stats               /* Statistics */
+);
+
+/**
+ * @brief Releases the resources of a prefetch stage.
+ *
+ * The worker must have returned from danp_ftp_prefetch_run().
+ *
+ * @param[in] prefetch Pointer to the prefetch stage.
+ */
+extern void danp_ftp_prefetch_deinit(
+    danp_ftp_prefetch_t *prefetch                  /* Prefetch stage */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_PREFETCH_H */
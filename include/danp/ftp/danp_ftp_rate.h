@@ -0,0 +1,111 @@
+/* danp_ftp_rate.h - token bucket rate limiting for the FTP send path */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_RATE_H
+#define INC_DANP_FTP_RATE_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+
+/* Types */
+
+struct danp_ftp_rate_limiter_s
+{
+    uint32_t rate_bytes_per_sec;                   /* Sustained rate */
+    uint32_t burst_bytes;                          /* Bucket depth */
+    uint64_t tokens;                               /* Available credit in byte-microseconds */
+    uint64_t last_update_us;                       /* Time the credit was last refilled */
+    danp_ftp_mutex_t lock;
+    bool is_initialized;
+};
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a token bucket rate limiter.
+ *
+ * The bucket starts full. A small burst paces packets evenly at the configured rate, a larger one
+ * lets short transfers pass at line rate while bulk transfers settle to the sustained rate.
+ *
+ * @param[out] limiter             Pointer to the rate limiter to initialize.
+ * @param[in]  rate_bytes_per_sec  Sustained rate in bytes per second.
+ * @param[in]  burst_bytes         Bucket depth in bytes, at least one packet.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_rate_limiter_init(
+    danp_ftp_rate_limiter_t *limiter,              /* Rate limiter */
+    uint32_t rate_bytes_per_sec,                   /* Sustained rate */
+    uint32_t burst_bytes                           /* Bucket depth */
+);
+
+/**
+ * @brief Releases the resources of a rate limiter.
+ *
+ * @param[in] limiter Pointer to the rate limiter.
+ */
+extern void danp_ftp_rate_limiter_deinit(
+    danp_ftp_rate_limiter_t *limiter               /* Rate limiter */
+);
+
+/**
+ * @brief Takes credit for sending bytes, sleeping until the credit is available.
+ *
+ * Credit is reserved before sleeping, so concurrent callers queue behind each other instead of
+ * waking up together.
+ *
+ * @param[in] limiter  Pointer to the rate limiter.
+ * @param[in] bytes    Number of bytes about to be sent.
+ *
+ * @return Time slept in microseconds.
+ */
+extern uint32_t danp_ftp_rate_limiter_acquire(
+    danp_ftp_rate_limiter_t *limiter,              /* Rate limiter */
+    size_t bytes                                   /* Bytes to send */
+);
+
+/**
+ * @brief Attaches a rate limiter to an FTP handle.
+ *
+ * Data packets sent on the handle are paced by the limiter. A limiter may be shared by several
+ * handles to give them a common budget. Must be called after the handle is initialized.
+ *
+ * @param[in] handle   Pointer to the initialized FTP handle.
+ * @param[in] limiter  Pointer to the rate limiter, NULL to remove it.
+ */
+extern void danp_ftp_set_rate_limiter(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_rate_limiter_t *limiter               /* Rate limiter */
+);
+
+/**
+ * @brief Sets the rate limiter applied to data packets of all handles.
+ *
+ * The global limiter is applied in addition to a per-handle limiter. Set it before transfers start.
+ *
+ * @param[in] limiter Pointer to the rate limiter, NULL to remove it.
+ */
+extern void danp_ftp_set_global_rate_limiter(
+    danp_ftp_rate_limiter_t *limiter               /* Rate limiter */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_RATE_H */
@@ -0,0 +1,166 @@
+/* danp_ftp_sched.h - priority scheduling of concurrent transfers sharing a link */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_SCHED_H
+#define INC_DANP_FTP_SCHED_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_SCHED_CLASSES
+#define CONFIG_DANP_FTP_SCHED_CLASSES         (4)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_SCHED_CLASSES                (CONFIG_DANP_FTP_SCHED_CLASSES)
+
+/* Class 0 is the most urgent */
+#define DANP_FTP_SCHED_PRIORITY_HIGHEST       (0)
+#define DANP_FTP_SCHED_PRIORITY_LOWEST        (DANP_FTP_SCHED_CLASSES - 1)
+
+/* Types */
+
+typedef enum danp_ftp_sched_mode_e
+{
+    DANP_FTP_SCHED_MODE_STRICT = 0,                /* Lower class always goes first */
+    DANP_FTP_SCHED_MODE_WEIGHTED,                  /* Classes share the link by weight */
+} danp_ftp_sched_mode_t;
+
+typedef struct danp_ftp_scheduler_config_s
+{
+    danp_ftp_sched_mode_t mode;                    /* Scheduling policy */
+    uint16_t weights[DANP_FTP_SCHED_CLASSES];      /* Chunk share per class, weighted mode only */
+} danp_ftp_scheduler_config_t;
+
+typedef struct danp_ftp_sched_stats_s
+{
+    uint32_t grants;                               /* Chunks sent by the class */
+    uint64_t wait_time_us;                         /* Total queueing latency */
+    uint32_t max_wait_us;                          /* Worst queueing latency of one chunk */
+    uint32_t first_wait_us;                        /* Queueing latency of the last first chunk */
+} danp_ftp_sched_stats_t;
+
+struct danp_ftp_scheduler_s
+{
+    danp_ftp_sched_mode_t mode;
+    uint32_t stride[DANP_FTP_SCHED_CLASSES];       /* Pass increment per grant */
+    uint64_t pass[DANP_FTP_SCHED_CLASSES];         /* Virtual time of the next grant */
+    uint64_t global_pass;                          /* Pass of the last grant */
+    uint32_t next_ticket[DANP_FTP_SCHED_CLASSES];  /* FIFO order within a class */
+    uint32_t now_serving[DANP_FTP_SCHED_CLASSES];
+    uint32_t abandoned[DANP_FTP_SCHED_CLASSES];    /* Cancelled tickets, bit 0 is now_serving */
+    uint16_t waiting[DANP_FTP_SCHED_CLASSES];      /* Transfers queued per class */
+    bool is_busy;                                  /* A chunk exchange owns the link */
+    danp_ftp_sched_stats_t stats[DANP_FTP_SCHED_CLASSES];
+    danp_ftp_mutex_t lock;
+    danp_ftp_cond_t changed;
+    bool is_initialized;
+};
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a transfer scheduler for one link.
+ *
+ * Handles attached to the same scheduler exchange one chunk at a time; before every chunk a
+ * transfer queues in its priority class and the scheduler picks the next class:
+ *   - DANP_FTP_SCHED_MODE_STRICT: the lowest waiting class, so an urgent transfer preempts bulk
+ *     ones after the chunk in flight.
+ *   - DANP_FTP_SCHED_MODE_WEIGHTED: stride scheduling, each busy class gets chunks in proportion
+ *     to its weight and no class starves.
+ * Transfers in the same class are served in arrival order. The scheduler is work-conserving: a
+ * lower class still gets the link while the urgent transfers are between two chunks.
+ *
+ * @param[out] scheduler  Pointer to the scheduler to initialize.
+ * @param[in]  config     Pointer to the configuration, NULL for strict priority.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_scheduler_init(
+    danp_ftp_scheduler_t *scheduler,               /* Scheduler */
+    const danp_ftp_scheduler_config_t *config      /* Configuration */
+);
+
+/**
+ * @brief Releases the resources of a scheduler.
+ *
+ * No transfer may use the scheduler any more.
+ *
+ * @param[in] scheduler Pointer to the scheduler.
+ */
+extern void danp_ftp_scheduler_deinit(
+    danp_ftp_scheduler_t *scheduler                /* Scheduler */
+);
+
+/**
+ * @brief Waits until the scheduler grants the link to a transfer of the given class.
+ *
+ * Called by the transfer functions before every chunk; exposed for custom transfer loops.
+ *
+ * @param[in] scheduler  Pointer to the scheduler.
+ * @param[in] priority   Priority class of the transfer.
+ * @param[in] is_first   True for the first chunk of a transfer.
+ *
+ * @return Queueing latency in microseconds.
+ */
+extern uint32_t danp_ftp_scheduler_acquire(
+    danp_ftp_scheduler_t *scheduler,               /* Scheduler */
+    uint8_t priority,                              /* Priority class */
+    bool is_first                                  /* First chunk of a transfer */
+);
+
+/**
+ * @brief Returns the link after a chunk exchange.
+ *
+ * @param[in] scheduler Pointer to the scheduler.
+ */
+extern void danp_ftp_scheduler_release(
+    danp_ftp_scheduler_t *scheduler                /* Scheduler */
+);
+
+/**
+ * @brief Reads the queueing statistics of a priority class.
+ *
+ * @param[in]  scheduler  Pointer to the scheduler.
+ * @param[in]  priority   Priority class.
+ * @param[out] stats      Pointer to store the statistics.
+ */
+extern void danp_ftp_scheduler_get_stats(
+    danp_ftp_scheduler_t *scheduler,               /* Scheduler */
+    uint8_t priority,                              /* Priority class */
+    danp_ftp_sched_stats_t *stats                  /* Statistics */
+);
+
+/**
+ * @brief Attaches a scheduler and priority class to an FTP handle.
+ *
+ * Data chunks sent or received on the handle are then scheduled against the other handles of
+ * the scheduler. Must be called after the handle is initialized.
+ *
+ * @param[in] handle     Pointer to the initialized FTP handle.
+ * @param[in] scheduler  Pointer to the scheduler, NULL to remove it.
+ * @param[in] priority   Priority class, clamped to DANP_FTP_SCHED_PRIORITY_LOWEST.
+ */
+extern void danp_ftp_set_priority(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_scheduler_t *scheduler,               /* Scheduler */
+    uint8_t priority                               /* Priority class */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_SCHED_H */
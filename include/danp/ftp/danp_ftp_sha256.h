@@ -0,0 +1,90 @@
+/* danp_ftp_sha256.h - incremental SHA-256 for chunk and file digests */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_SHA256_H
+#define INC_DANP_FTP_SHA256_H
+
+/* Includes */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+
+/* Definitions */
+
+#define DANP_FTP_SHA256_SIZE                  (32)
+#define DANP_FTP_SHA256_BLOCK_SIZE            (64)
+
+/* Types */
+
+typedef struct danp_ftp_sha256_s
+{
+    uint32_t state[8];
+    uint64_t length;                               /* Bytes hashed so far */
+    uint8_t block[DANP_FTP_SHA256_BLOCK_SIZE];     /* Pending partial block */
+    size_t block_used;
+} danp_ftp_sha256_t;
+
+/* External Declarations */
+
+/**
+ * @brief Starts a SHA-256 computation.
+ *
+ * @param[out] sha Pointer to the hash context.
+ */
+extern void danp_ftp_sha256_init(
+    danp_ftp_sha256_t *sha                         /* Hash context */
+);
+
+/**
+ * @brief Feeds data into a SHA-256 computation.
+ *
+ * May be called any number of times with pieces of any size.
+ *
+ * @param[in] sha     Pointer to the hash context.
+ * @param[in] data    Data to hash.
+ * @param[in] length  Size of the data.
+ */
+extern void danp_ftp_sha256_update(
+    danp_ftp_sha256_t *sha,                        /* Hash context */
+    const uint8_t *data,                           /* Data */
+    size_t length                                  /* Data size */
+);
+
+/**
+ * @brief Finishes a SHA-256 computation.
+ *
+ * @param[in]  sha     Pointer to the hash context.
+ * @param[out] digest  Buffer of DANP_FTP_SHA256_SIZE bytes for the digest.
+ */
+extern void danp_ftp_sha256_final(
+    danp_ftp_sha256_t *sha,                        /* Hash context */
+    uint8_t *digest                                /* Digest */
+);
+
+/**
+ * @brief Hashes a buffer in one call.
+ *
+ * @param[in]  data    Data to hash.
+ * @param[in]  length  Size of the data.
+ * @param[out] digest  Buffer of DANP_FTP_SHA256_SIZE bytes for the digest.
+ */
+extern void danp_ftp_sha256(
+    const uint8_t *data,                           /* Data */
+    size_t length,                                 /* Data size */
+    uint8_t *digest                                /* Digest */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_SHA256_H */
@@ -0,0 +1,76 @@
+/* danp_ftp_trace.h - binary packet trace ring buffer */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_TRACE_H
+#define INC_DANP_FTP_TRACE_H
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_TRACE_BUFFER_SIZE
+#define CONFIG_DANP_FTP_TRACE_BUFFER_SIZE     (256)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_TRACE_BUFFER_SIZE            (CONFIG_DANP_FTP_TRACE_BUFFER_SIZE)
+
+#define DANP_FTP_TRACE_DIRECTION_TX           (0)
+#define DANP_FTP_TRACE_DIRECTION_RX           (1)
+
+/* Types */
+
+/*
+ * Fixed 20-byte little-endian layout, decoded offline by scripts/trace_decode.py.
+ * Keep both in sync when changing this structure.
+ */
+typedef struct danp_ftp_trace_record_s
+{
+    uint32_t index;                                /* Event number + 1, 0 while being written */
+    uint32_t timestamp_us;                         /* Monotonic time, wraps after ~71 minutes */
+    uint16_t sequence_number;                      /* Packet sequence number */
+    uint16_t payload_length;                       /* Packet payload length */
+    uint16_t dst_node;                             /* Peer node of the handle */
+    uint8_t type;                                  /* danp_ftp_packet_type_t */
+    uint8_t flags;                                 /* Packet flags */
+    uint8_t direction;                             /* DANP_FTP_TRACE_DIRECTION_* */
+    uint8_t reserved[3];
+} danp_ftp_trace_record_t;
+
+/* External Declarations */
+
+#if defined(CONFIG_DANP_FTP_TRACE)
+
+/**
+ * @brief Copies the most recent trace records out of the ring buffer.
+ *
+ * Records are written lock-free by the send and receive paths; this function may run
+ * concurrently with them and skips records that are overwritten while being copied.
+ * The output is ordered oldest first and can be written to a file as-is for the offline decoder.
+ *
+ * @param[out] records      Buffer for the copied records.
+ * @param[in]  max_records  Capacity of `records`.
+ *
+ * @return Number of records copied.
+ */
+extern size_t danp_ftp_trace_snapshot(
+    danp_ftp_trace_record_t *records,              /* Output records */
+    size_t max_records                             /* Output capacity */
+);
+
+#endif /* CONFIG_DANP_FTP_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_TRACE_H */
@@ -0,0 +1,168 @@
+/* danp_ftp_writeback.h - write-behind queue between the receive path and a slow sink */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_WRITEBACK_H
+#define INC_DANP_FTP_WRITEBACK_H
+
+/* Includes */
+
+#include <stdbool.h>
+#include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_WRITEBACK_DEPTH
+#define CONFIG_DANP_FTP_WRITEBACK_DEPTH       (8)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_WRITEBACK_DEPTH              (CONFIG_DANP_FTP_WRITEBACK_DEPTH)
+
+/* Types */
+
+typedef struct danp_ftp_writeback_slot_s
+{
+    uint8_t data[DANP_FTP_MAX_CHUNK_SIZE];
+    size_t offset;                                 /* File offset of the chunk */
+    uint16_t length;                               /* Bytes in `data` */
+    uint8_t more;                                  /* Receive path `more` input */
+} danp_ftp_writeback_slot_t;
+
+typedef struct danp_ftp_writeback_stats_s
+{
+    uint32_t chunks;                               /* Chunks written to the sink */
+    uint32_t max_queued;                           /* Highest number of queued chunks */
+    uint64_t sink_time_us;                         /* Time spent in the sink callback */
+    uint64_t stall_time_us;                        /* Time the receive path waited for a slot */
+} danp_ftp_writeback_stats_t;
+
+typedef struct danp_ftp_writeback_s
+{
+    danp_ftp_writeback_slot_t slots[DANP_FTP_WRITEBACK_DEPTH];
+    danp_ftp_sink_cb_t sink;                       /* Wrapped sink callback */
+    void *sink_data;                               /* Wrapped sink user data */
+    danp_ftp_handle_t *handle;                     /* Handle passed to the wrapped sink */
+    size_t head;                                   /* Next slot to drain */
+    size_t count;                                  /* Queued slots */
+    bool is_finished;                              /* Final chunk has been written */
+    bool is_stopped;                               /* Stop requested */
+    danp_ftp_status_t result;                      /* First sink error, OK otherwise */
+    size_t error_offset;                           /* Offset of the chunk that failed */
+    danp_ftp_writeback_stats_t stats;
+    danp_ftp_mutex_t lock;
+    danp_ftp_cond_t changed;
+} danp_ftp_writeback_t;
+
+/* External Declarations */
+
+/**
+ * @brief Initializes a write-behind queue in front of a sink callback.
+ *
+ * Start danp_ftp_writeback_run() on a worker thread, then pass danp_ftp_writeback_sink_cb() with
+ * the queue as user data to danp_ftp_receive(). Each received chunk is copied into one of
+ * DANP_FTP_WRITEBACK_DEPTH slots and ACKed at once; the worker writes the chunks to the wrapped
+ * sink in offset order. The receive path only blocks when every slot is in use.
+ *
+ * A sink error is reported on the next chunk, which aborts the transfer. The final chunk waits
+ * until the queue has drained, so a successful danp_ftp_receive() means every byte reached the
+ * sink.
+ *
+ * @param[out] writeback  Pointer to the queue to initialize.
+ * @param[in]  handle     Handle passed to the wrapped sink callback.
+ * @param[in]  sink       Wrapped sink callback.
+ * @param[in]  sink_data  User data of the wrapped sink callback.
+ *
+ * @return Status code indicating the result of the initialization.
+ */
+extern danp_ftp_status_t danp_ftp_writeback_init(
+    danp_ftp_writeback_t *writeback,               /* Write-behind queue */
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_sink_cb_t sink,                       /* Wrapped sink callback */
+    void *sink_data                                /* Wrapped sink user data */
+);
+
+/**
+ * @brief Runs the write-behind worker until the final chunk is written or the queue is stopped.
+ *
+ * Call from a dedicated thread. After a sink error the worker discards the remaining chunks.
+ *
+ * @param[in] writeback Pointer to the queue.
+ */
+extern void danp_ftp_writeback_run(
+    danp_ftp_writeback_t *writeback                /* Write-behind queue */
+);
+
+/**
+ * @brief Sink callback queueing received chunks for the worker.
+ *
+ * `user_data` is a danp_ftp_writeback_t.
+ */
+extern danp_ftp_status_t danp_ftp_writeback_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data
+);
+
+/**
+ * @brief Waits until every queued chunk has been written.
+ *
+ * Use after a transfer that ended without a final chunk, e.g. on a receive error, before
+ * stopping the worker.
+ *
+ * @param[in] writeback Pointer to the queue.
+ *
+ * @return The first sink error, or DANP_FTP_STATUS_OK.
+ */
+extern danp_ftp_status_t danp_ftp_writeback_flush(
+    danp_ftp_writeback_t *writeback                /* Write-behind queue */
+);
+
+/**
+ * @brief Stops the worker.
+ *
+ * Chunks still queued are discarded; call danp_ftp_writeback_flush() first to keep them.
+ *
+ * @param[in] writeback Pointer to the queue.
+ */
+extern void danp_ftp_writeback_stop(
+    danp_ftp_writeback_t *writeback                /* Write-behind queue */
+);
+
+/**
+ * @brief Reads the write-behind statistics.
+ *
+ * @param[in]  writeback  Pointer to the queue.
+ * @param[out] stats      Pointer to store the statistics.
+ */
+extern void danp_ftp_writeback_get_stats(
+    danp_ftp_writeback_t *writeback,               /* Write-behind queue */
+    danp_ftp_writeback_stats_t *stats              /* Statistics */
+);
+
+/**
+ * @brief Releases the resources of a write-behind queue.
+ *
+ * The worker must have returned from danp_ftp_writeback_run().
+ *
+ * @param[in] writeback Pointer to the queue.
+ */
+extern void danp_ftp_writeback_deinit(
+    danp_ftp_writeback_t *writeback                /* Write-behind queue */
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_WRITEBACK_H */
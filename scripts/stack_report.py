@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+
+# stack_report.py - Report the worst-case stack depth of the DANP FTP entry points
+#
+# Reads the call graph files written by GCC with -fstack-usage -fcallgraph-info=su, which the
+# DANP_FTP_STACK_USAGE CMake option enables, and walks the deepest static call chain below each
+# entry point. Callbacks (indirect calls) and functions outside the library (danp_send, logging)
+# are reported but not counted; add their own stack use on the target.
+#
+# With --budget the report also checks each entry point against the budget of a workspace profile
+# and exits with status 2 when one is over. The budgets below are the GCC x86-64 Release figures
+# plus at least 128 bytes of headroom, rounded up to 64; raise them on purpose, never to silence
+# the check.
+#
+# Usage: ./scripts/stack_report.py [--budget static|stack] <build dir> [function ...]
+
+import argparse
+import os
+import re
+import sys
+
+NODE_RE = re.compile(r'node: \{ title: "([^"]+)" label: "[^"]*\\n(\d+) bytes \(([\w,]+)\)')
+EXTERN_RE = re.compile(r'node: \{ title: "([^"]+)" label: "[^"]*" shape : ellipse')
+EDGE_RE = re.compile(r'edge: \{ sourcename: "([^"]+)" targetname: "([^"]+)"')
+
+DEFAULT_ENTRY_POINTS = [
+    "danp_ftp_transmit",
+    "danp_ftp_receive",
+    "danp_ftp_receive_batch",
+    "danp_ftp_list",
+    "danp_ftp_ping",
+    "danp_ftp_multicast_transmit",
+    "danp_ftp_transmit_dedup",
+    "danp_ftp_receive_dedup",
+]
+
+# Worst-case stack depth in bytes allowed per entry point, per workspace profile
+BUDGETS = {
+    # DANP_FTP_STATIC_WORKSPACE=ON: transfer buffers come from the static pool
+    "static": {
+        "danp_ftp_transmit": 640,
+        "danp_ftp_receive": 512,
+        "danp_ftp_receive_batch": 512,
+        "danp_ftp_list": 512,
+        "danp_ftp_ping": 384,
+        "danp_ftp_multicast_transmit": 576,
+        "danp_ftp_transmit_dedup": 704,
+        "danp_ftp_receive_dedup": 704,
+    },
+    # DANP_FTP_STATIC_WORKSPACE=OFF: transfer buffers live on the caller's stack
+    "stack": {
+        "danp_ftp_transmit": 1024,
+        "danp_ftp_receive": 896,
+        "danp_ftp_receive_batch": 896,
+        "danp_ftp_list": 896,
+        "danp_ftp_ping": 768,
+        "danp_ftp_multicast_transmit": 960,
+        "danp_ftp_transmit_dedup": 1088,
+        "danp_ftp_receive_dedup": 1088,
+    },
+}
+
+
+def load(build_dir):
+    frames = {}
+    calls = {}
+    for root, _, files in os.walk(build_dir):
+        for name in files:
+            if not name.endswith(".ci"):
+                continue
+            with open(os.path.join(root, name), encoding="utf-8") as graph:
+                for line in graph:
+                    match = NODE_RE.search(line)
+                    if match:
+                        kind = match.group(3)
+                        frames[match.group(1)] = (int(match.group(2)), kind == "dynamic")
+                        continue
+                    match = EDGE_RE.search(line)
+                    if match:
+                        calls.setdefault(match.group(1), set()).add(match.group(2))
+    return frames, calls
+
+
+def deepest(function, frames, calls, path, unknown):
+    if function in path:
+        unknown.add(function + " (recursion)")
+        return 0, []
+    if function not in frames:
+        unknown.add(function)
+        return 0, []
+    size, dynamic = frames[function]
+    if dynamic:
+        unknown.add(function + " (dynamic frame)")
+    best_size, best_chain = 0, []
+    for callee in sorted(calls.get(function, ())):
+        callee_size, callee_chain = deepest(callee, frames, calls, path | {function}, unknown)
+        if callee_size > best_size:
+            best_size, best_chain = callee_size, callee_chain
+    return size + best_size, [(function, size)] + best_chain
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report the stack depth of DANP FTP entry points")
+    parser.add_argument("--budget", choices=sorted(BUDGETS), help="fail when over this profile")
+    parser.add_argument("build_dir", help="directory holding the .ci files")
+    parser.add_argument("functions", nargs="*", help="entry points (default: the public API)")
+    args = parser.parse_args()
+
+    frames, calls = load(args.build_dir)
+    if not frames:
+        print("No .ci files found, configure with -DDANP_FTP_STACK_USAGE=ON", file=sys.stderr)
+        return 1
+
+    budgets = BUDGETS.get(args.budget, {})
+    over = []
+    for function in args.functions or DEFAULT_ENTRY_POINTS:
+        if function not in frames:
+            continue
+        unknown = set()
+        total, chain = deepest(function, frames, calls, frozenset(), unknown)
+        budget = budgets.get(function)
+        if budget is None:
+            print(f"{function}: {total} bytes")
+        else:
+            print(f"{function}: {total} bytes (budget {budget})")
+            if total > budget:
+                over.append(function)
+        for name, size in chain:
+            print(f"    {size:>6}  {name}")
+        unknown.discard("__indirect_call")
+        if unknown:
+            print(f"    not counted: {', '.join(sorted(unknown))}")
+
+    if over:
+        print(f"Over the {args.budget} budget: {', '.join(over)}", file=sys.stderr)
+        return 2
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
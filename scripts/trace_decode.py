@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+
+# trace_decode.py - Decode a DANP FTP binary trace dump
+#
+# The dump is the raw array returned by danp_ftp_trace_snapshot(), written to a file as-is.
+#
+# Usage: ./scripts/trace_decode.py <dump.bin> [--big-endian]
+
+import struct
+import sys
+
+# Must match danp_ftp_trace_record_t in include/danp/ftp/danp_ftp_trace.h
+RECORD_FORMAT = "IIHHHBBB3x"
+RECORD_SIZE = struct.calcsize("<" + RECORD_FORMAT)
+
+PACKET_TYPES = {0: "COMMAND", 1: "RESPONSE", 2: "ACK", 3: "NACK", 4: "DATA"}
+DIRECTIONS = {0: "TX", 1: "RX"}
+
+
+def decode(data, byte_order):
+    previous_us = None
+    for offset in range(0, len(data) - RECORD_SIZE + 1, RECORD_SIZE):
+        index, timestamp_us, seq, length, node, ptype, flags, direction = struct.unpack_from(
+            byte_order + RECORD_FORMAT, data, offset
+        )
+        # Timestamps are 32-bit and wrap, deltas stay correct across one wrap
+        delta_us = 0 if previous_us is None else (timestamp_us - previous_us) & 0xFFFFFFFF
+        previous_us = timestamp_us
+        print(
+            f"#{index - 1:<8} t={timestamp_us:>10}us +{delta_us:<8} "
+            f"{DIRECTIONS.get(direction, '??')} node={node:<5} "
+            f"{PACKET_TYPES.get(ptype, str(ptype)):<8} flags=0x{flags:02X} "
+            f"seq={seq:<5} len={length}"
+        )
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(f"Usage: {sys.argv[0]} <dump.bin> [--big-endian]", file=sys.stderr)
+        return 1
+
+    byte_order = ">" if "--big-endian" in sys.argv[2:] else "<"
+    with open(sys.argv[1], "rb") as dump:
+        decode(dump.read(), byte_order)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
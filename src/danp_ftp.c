@@ -5,8 +5,11 @@
 /* Includes */
 
 #include "danp/ftp/danp_ftp.h"
+#include "danp/ftp/danp_ftp_port.h"
+#include "danp/ftp/danp_ftp_sha256.h"
+#include "danp/ftp/danp_ftp_trace.h"
 #include "danp/danp.h"
-#include "danp_debug.h"
+#include "danp_ftp_internal.h"
 #include <string.h>
 
 /* Imports */
@@ -14,38 +17,19 @@
 
 /* Definitions */
 
-#define DANP_FTP_PORT                         (CONFIG_DANP_FTP_SERVICE_PORT)
-#define DANP_FTP_MAX_PAYLOAD_SIZE             (DANP_MAX_PACKET_SIZE - sizeof(danp_ftp_header_t))
-#define DANP_FTP_DEFAULT_CHUNK_SIZE           (64)
-#define DANP_FTP_DEFAULT_TIMEOUT_MS           (5000)
-#define DANP_FTP_DEFAULT_MAX_RETRIES          (3)
-
-#define DANP_FTP_CMD_REQUEST_READ             (0x01)
-#define DANP_FTP_CMD_REQUEST_WRITE            (0x02)
-#define DANP_FTP_CMD_ABORT                    (0x03)
-
-#define DANP_FTP_RESP_OK                      (0x00)
-#define DANP_FTP_RESP_ERROR                   (0x01)
-#define DANP_FTP_RESP_FILE_NOT_FOUND          (0x02)
-#define DANP_FTP_RESP_BUSY                    (0x03)
-
-#define DANP_FTP_FLAG_NONE                    (0x00)
-#define DANP_FTP_FLAG_LAST_CHUNK              (0x01)
-#define DANP_FTP_FLAG_FIRST_CHUNK             (0x02)
 
 /* Types */
 
-typedef struct danp_ftp_message_s
-{
-    danp_ftp_header_t header;
-    uint8_t payload[DANP_FTP_MAX_PAYLOAD_SIZE];
-} PACKED danp_ftp_message_t;
 
 /* Forward Declarations */
 
 
 /* Variables */
 
+#if defined(CONFIG_DANP_FTP_STATIC_WORKSPACE) && (DANP_FTP_WORKSPACE_POOL_SIZE > 0)
+static danp_ftp_workspace_t WorkspacePool[DANP_FTP_WORKSPACE_POOL_SIZE];
+static bool WorkspacePoolClaimed[DANP_FTP_WORKSPACE_POOL_SIZE];
+#endif
 
 /* Functions */
 
@@ -78,29 +62,78 @@ static uint32_t danp_ftp_calculate_crc(const uint8_t *data, size_t length)
     return crc ^ 0xFFFFFFFFU;
 }
 
+/**
+ * @brief Read a little-endian 32-bit value from a byte buffer.
+ * @param data Pointer to the first byte.
+ * @return Decoded value.
+ */
+uint32_t danp_ftp_read_u32_le(const uint8_t *data)
+{
+    return (uint32_t)data[0] |
+        ((uint32_t)data[1] << 8) |
+        ((uint32_t)data[2] << 16) |
+        ((uint32_t)data[3] << 24);
+}
+
+/**
+ * @brief Read a little-endian 16-bit value from a byte buffer.
+ * @param data Pointer to the first byte.
+ * @return Decoded value.
+ */
+uint16_t danp_ftp_read_u16_le(const uint8_t *data)
+{
+    return (uint16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8));
+}
+
+/**
+ * @brief Write a 32-bit value to a byte buffer in little-endian order.
+ * @param data Pointer to the first byte.
+ * @param value Value to encode.
+ */
+void danp_ftp_write_u32_le(uint8_t *data, uint32_t value)
+{
+    data[0] = (uint8_t)(value);
+    data[1] = (uint8_t)(value >> 8);
+    data[2] = (uint8_t)(value >> 16);
+    data[3] = (uint8_t)(value >> 24);
+}
+
+/**
+ * @brief Write a 16-bit value to a byte buffer in little-endian order.
+ * @param data Pointer to the first byte.
+ * @param value Value to encode.
+ */
+void danp_ftp_write_u16_le(uint8_t *data, uint16_t value)
+{
+    data[0] = (uint8_t)(value);
+    data[1] = (uint8_t)(value >> 8);
+}
+
 /**
  * @brief Send an FTP protocol message.
  * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer, the message is built in its outgoing packet.
  * @param type Packet type.
  * @param flags Packet flags.
  * @param payload Pointer to the payload data.
  * @param payload_length Length of the payload.
  * @return Status code.
  */
-static danp_ftp_status_t danp_ftp_send_message(
+danp_ftp_status_t danp_ftp_send_message(
     danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
     danp_ftp_packet_type_t type,
     uint8_t flags,
     const uint8_t *payload,
     uint16_t payload_length)
 {
     danp_ftp_status_t status = DANP_FTP_STATUS_OK;
-    danp_ftp_message_t message;
+    danp_ftp_message_t *message;
     int32_t send_result;
 
     for (;;)
     {
-        if (!handle || !handle->socket)
+        if (!handle || !handle->socket || !workspace)
         {
             status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
@@ -108,41 +141,63 @@ static danp_ftp_status_t danp_ftp_send_message(
 
         if (payload_length > DANP_FTP_MAX_PAYLOAD_SIZE)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP payload too large: %u", payload_length);
+            DANP_FTP_LOG_ERR("FTP payload too large: %u", payload_length);
             status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
         }
 
-        memset(&message, 0, sizeof(danp_ftp_message_t));
+        /* The remote side already got an ABORT, nothing more goes out after it */
+        if (danp_ftp_is_cancelled(handle))
+        {
+            status = DANP_FTP_STATUS_CANCELLED;
+            break;
+        }
+
+        message = DANP_FTP_TX_MESSAGE(workspace);
 
-        message.header.type = (uint8_t)type;
-        message.header.flags = flags;
-        message.header.sequence_number = handle->sequence_number;
-        message.header.payload_length = payload_length;
+        message->header.type = (uint8_t)type;
+        message->header.flags = flags;
+        message->header.sequence_number = handle->sequence_number;
+        message->header.payload_length = payload_length;
 
-        if (payload && payload_length > 0)
+        /* Payloads built in place in the workspace are sent without a copy */
+        if (payload && payload_length > 0 && payload != message->payload)
         {
-            memcpy(message.payload, payload, payload_length);
+            memcpy(message->payload, payload, payload_length);
         }
 
-        message.header.crc = danp_ftp_calculate_crc(
-            message.payload,
+        message->header.crc = danp_ftp_calculate_crc(
+            message->payload,
             payload_length);
 
+        if (type == DANP_FTP_PACKET_TYPE_DATA)
+        {
+            status = danp_ftp_rate_limit_packet(
+                handle,
+                sizeof(danp_ftp_header_t) + payload_length);
+            if (status < 0)
+            {
+                break;
+            }
+        }
+
         send_result = danp_send(
             handle->socket,
-            &message,
+            message,
             sizeof(danp_ftp_header_t) + payload_length);
 
         if (send_result < 0)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP send failed: %d", send_result);
+            DANP_FTP_LOG_ERR("FTP send failed: %d", send_result);
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
         }
 
-        danp_log_message(
-            DANP_LOG_LEVEL_DBG,
+        DANP_FTP_TRACE(DANP_FTP_TRACE_DIRECTION_TX, handle, message->header);
+
+        danp_ftp_progress_report(handle, false);
+
+        DANP_FTP_LOG_DBG(
             "FTP TX: type=%u flags=0x%02X seq=%u len=%u",
             type,
             flags,
@@ -160,9 +215,9 @@ static danp_ftp_status_t danp_ftp_send_message(
  * @param handle Pointer to the FTP handle.
  * @param message Pointer to store the received message.
  * @param timeout_ms Timeout in milliseconds.
- * @return Status code or bytes received.
+ * @return Status code or bytes received, DANP_FTP_STATUS_CANCELLED on an ABORT from the remote.
  */
-static danp_ftp_status_t danp_ftp_receive_message(
+danp_ftp_status_t danp_ftp_receive_message(
     danp_ftp_handle_t *handle,
     danp_ftp_message_t *message,
     uint32_t timeout_ms)
@@ -170,6 +225,8 @@ static danp_ftp_status_t danp_ftp_receive_message(
     danp_ftp_status_t status = DANP_FTP_STATUS_OK;
     int32_t recv_result;
     uint32_t calculated_crc;
+    uint32_t remaining_ms = timeout_ms;
+    uint32_t slice_ms;
 
     for (;;)
     {
@@ -179,23 +236,38 @@ static danp_ftp_status_t danp_ftp_receive_message(
             break;
         }
 
-        memset(message, 0, sizeof(danp_ftp_message_t));
+        memset(&message->header, 0, sizeof(danp_ftp_header_t));
 
-        recv_result = danp_recv(
-            handle->socket,
-            message,
-            sizeof(danp_ftp_message_t),
-            timeout_ms);
+        /* Waits are cut in slices so that a cancelled transfer does not sit out the timeout */
+        do
+        {
+            slice_ms = (remaining_ms < DANP_FTP_CANCEL_POLL_MS) ?
+                remaining_ms : DANP_FTP_CANCEL_POLL_MS;
+
+            recv_result = danp_recv(
+                handle->socket,
+                message,
+                sizeof(danp_ftp_message_t),
+                slice_ms);
+
+            remaining_ms -= slice_ms;
+        } while (recv_result == 0 && remaining_ms > 0 && !danp_ftp_is_cancelled(handle));
+
+        if (danp_ftp_is_cancelled(handle))
+        {
+            status = DANP_FTP_STATUS_CANCELLED;
+            break;
+        }
 
         if (recv_result < (int32_t)sizeof(danp_ftp_header_t))
         {
             if (recv_result == 0)
             {
-                danp_log_message(DANP_LOG_LEVEL_WRN, "FTP receive timeout");
+                DANP_FTP_LOG_WRN("FTP receive timeout");
             }
             else
             {
-                danp_log_message(DANP_LOG_LEVEL_ERR, "FTP receive failed: %d", recv_result);
+                DANP_FTP_LOG_ERR("FTP receive failed: %d", recv_result);
             }
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
@@ -207,8 +279,7 @@ static danp_ftp_status_t danp_ftp_receive_message(
 
         if (calculated_crc != message->header.crc)
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_WRN,
+            DANP_FTP_LOG_WRN(
                 "FTP CRC mismatch: expected=0x%08X got=0x%08X",
                 message->header.crc,
                 calculated_crc);
@@ -216,14 +287,26 @@ static danp_ftp_status_t danp_ftp_receive_message(
             break;
         }
 
-        danp_log_message(
-            DANP_LOG_LEVEL_DBG,
+        DANP_FTP_TRACE(DANP_FTP_TRACE_DIRECTION_RX, handle, message->header);
+
+        DANP_FTP_LOG_DBG(
             "FTP RX: type=%u flags=0x%02X seq=%u len=%u",
             message->header.type,
             message->header.flags,
             message->header.sequence_number,
             message->header.payload_length);
 
+        /* The remote side dropped the transfer, it answers nothing from now on */
+        if (message->header.type == DANP_FTP_PACKET_TYPE_COMMAND &&
+            message->header.payload_length >= 1 &&
+            message->payload[0] == DANP_FTP_CMD_ABORT)
+        {
+            DANP_FTP_LOG_WRN("FTP transfer aborted by remote");
+            __atomic_store_n(&handle->is_cancelled, true, __ATOMIC_RELEASE);
+            status = DANP_FTP_STATUS_CANCELLED;
+            break;
+        }
+
         status = (danp_ftp_status_t)message->header.payload_length;
 
         break;
@@ -235,56 +318,72 @@ static danp_ftp_status_t danp_ftp_receive_message(
 /**
  * @brief Wait for an ACK message with expected sequence number.
  * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer, the ACK lands in its incoming packet.
  * @param expected_seq Expected sequence number.
  * @param timeout_ms Timeout in milliseconds.
  * @return Status code.
  */
-static danp_ftp_status_t danp_ftp_wait_for_ack(
+danp_ftp_status_t danp_ftp_wait_for_ack(
     danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
     uint16_t expected_seq,
     uint32_t timeout_ms)
 {
     danp_ftp_status_t status = DANP_FTP_STATUS_OK;
-    danp_ftp_message_t message;
+    danp_ftp_message_t *message;
 
     for (;;)
     {
-        status = danp_ftp_receive_message(handle, &message, timeout_ms);
+        if (!handle || !workspace)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        message = DANP_FTP_RX_MESSAGE(workspace);
+
+        status = danp_ftp_receive_message(handle, message, timeout_ms);
         if (status < 0)
         {
             break;
         }
 
-        if (message.header.type == DANP_FTP_PACKET_TYPE_ACK)
+        if (message->header.type == DANP_FTP_PACKET_TYPE_ACK)
         {
-            if (message.header.sequence_number == expected_seq)
+            if (message->header.sequence_number == expected_seq)
             {
                 status = DANP_FTP_STATUS_OK;
                 break;
             }
             else
             {
-                danp_log_message(
-                    DANP_LOG_LEVEL_WRN,
+                DANP_FTP_LOG_WRN(
                     "FTP ACK seq mismatch: expected=%u got=%u",
                     expected_seq,
-                    message.header.sequence_number);
+                    message->header.sequence_number);
                 status = DANP_FTP_STATUS_TRANSFER_FAILED;
                 break;
             }
         }
-        else if (message.header.type == DANP_FTP_PACKET_TYPE_NACK)
+        else if (message->header.type == DANP_FTP_PACKET_TYPE_NACK)
         {
-            danp_log_message(DANP_LOG_LEVEL_WRN, "FTP received NACK");
+            /* The receiver already gave up on the file, resending the trailer cannot help */
+            if (message->header.flags & DANP_FTP_FLAG_DIGEST)
+            {
+                DANP_FTP_LOG_ERR("FTP receiver reported a digest mismatch");
+                status = DANP_FTP_STATUS_DIGEST_MISMATCH;
+                break;
+            }
+
+            DANP_FTP_LOG_WRN("FTP received NACK");
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
         }
         else
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_WRN,
+            DANP_FTP_LOG_WRN(
                 "FTP unexpected packet type: %u",
-                message.header.type);
+                message->header.type);
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
         }
@@ -296,217 +395,1480 @@ static danp_ftp_status_t danp_ftp_wait_for_ack(
 }
 
 /**
- * @brief Initializes the FTP handle for communication with a destination node.
- * @param handle Pointer to the FTP handle to initialize.
- * @param dst_node Destination node ID.
- * @return Status code indicating the result of the initialization.
+ * @brief Send a DATA message until it is acknowledged.
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer.
+ * @param flags Packet flags.
+ * @param payload Pointer to the payload data.
+ * @param payload_length Length of the payload.
+ * @param timeout_ms Timeout in milliseconds for each ACK.
+ * @param max_retries Maximum number of attempts.
+ * @return Status code.
  */
-danp_ftp_status_t danp_ftp_init(
+danp_ftp_status_t danp_ftp_send_data_reliable(
     danp_ftp_handle_t *handle,
-    uint16_t dst_node)
+    danp_ftp_workspace_t *workspace,
+    uint8_t flags,
+    const uint8_t *payload,
+    uint16_t payload_length,
+    uint32_t timeout_ms,
+    uint8_t max_retries)
 {
-    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
-    danp_socket_t *sock = NULL;
-    int32_t connect_result;
+    danp_ftp_status_t status = DANP_FTP_STATUS_TRANSFER_FAILED;
+    uint8_t retries = 0;
 
-    for (;;)
+    while (retries < max_retries)
     {
-        if (!handle)
+        status = danp_ftp_send_message(
+            handle,
+            workspace,
+            DANP_FTP_PACKET_TYPE_DATA,
+            flags,
+            payload,
+            payload_length);
+
+        if (status == DANP_FTP_STATUS_CANCELLED)
         {
-            status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
         }
 
-        memset(handle, 0, sizeof(danp_ftp_handle_t));
-
-        sock = danp_socket(DANP_TYPE_STREAM);
-        if (!sock)
+        if (status < 0)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP failed to create socket");
-            status = DANP_FTP_STATUS_ERROR;
-            break;
+            retries++;
+            continue;
         }
 
-        connect_result = danp_connect(sock, dst_node, DANP_FTP_PORT);
-        if (connect_result < 0)
+        status = danp_ftp_wait_for_ack(
+            handle,
+            workspace,
+            handle->sequence_number,
+            timeout_ms);
+
+        if (status == DANP_FTP_STATUS_OK ||
+            status == DANP_FTP_STATUS_CANCELLED ||
+            status == DANP_FTP_STATUS_DIGEST_MISMATCH)
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_ERR,
-                "FTP failed to connect to node %u: %d",
-                dst_node,
-                connect_result);
-            danp_close(sock);
-            status = DANP_FTP_STATUS_CONNECTION_FAILED;
             break;
         }
 
-        handle->socket = sock;
-        handle->dst_node = dst_node;
-        handle->sequence_number = 0;
-        handle->state = DANP_FTP_STATE_IDLE;
-        handle->total_bytes_transferred = 0;
-        handle->is_initialized = true;
-
-        danp_log_message(
-            DANP_LOG_LEVEL_INF,
-            "FTP initialized for node %u",
-            dst_node);
+        retries++;
+        DANP_FTP_LOG_WRN(
+            "FTP retry %u/%u for seq %u",
+            retries,
+            max_retries,
+            handle->sequence_number);
+    }
 
-        break;
+    if (retries >= max_retries)
+    {
+        DANP_FTP_LOG_ERR("FTP max retries exceeded");
+        status = DANP_FTP_STATUS_TRANSFER_FAILED;
     }
 
     return status;
 }
 
 /**
- * @brief Deinitializes the FTP handle and releases associated resources.
- * @param handle Pointer to the FTP handle to deinitialize.
+ * @brief Send a command message and wait for its response.
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer.
+ * @param command_payload Pointer to the command payload.
+ * @param command_len Length of the command payload.
+ * @param timeout_ms Timeout in milliseconds.
+ * @param response_code Pointer to store the response code.
+ * @return Status code.
  */
-void danp_ftp_deinit(danp_ftp_handle_t *handle)
+danp_ftp_status_t danp_ftp_exchange_command(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
+    const uint8_t *command_payload,
+    size_t command_len,
+    uint32_t timeout_ms,
+    uint8_t *response_code)
 {
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_message_t *response;
+
     for (;;)
     {
-        if (!handle)
+        if (!handle || !workspace)
         {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
         }
 
-        if (!handle->is_initialized)
+        response = DANP_FTP_RX_MESSAGE(workspace);
+        handle->sequence_number = 0;
+        __atomic_store_n(&handle->is_cancelled, false, __ATOMIC_RELAXED);
+        __atomic_store_n(&handle->state, DANP_FTP_STATE_CONNECTING, __ATOMIC_RELEASE);
+
+        status = danp_ftp_send_message(
+            handle,
+            workspace,
+            DANP_FTP_PACKET_TYPE_COMMAND,
+            DANP_FTP_FLAG_NONE,
+            command_payload,
+            (uint16_t)command_len);
+
+        if (status < 0)
         {
             break;
         }
 
-        if (handle->socket)
+        status = danp_ftp_receive_message(handle, response, timeout_ms);
+        if (status < 0)
         {
-            danp_close(handle->socket);
-            handle->socket = NULL;
+            break;
         }
 
-        handle->is_initialized = false;
-        handle->state = DANP_FTP_STATE_IDLE;
+        if (response->header.type != DANP_FTP_PACKET_TYPE_RESPONSE)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP unexpected response type: %u",
+                response->header.type);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
 
-        danp_log_message(DANP_LOG_LEVEL_INF, "FTP handle deinitialized");
+        *response_code = response->payload[0];
+        status = DANP_FTP_STATUS_OK;
 
         break;
     }
+
+    return status;
 }
 
 /**
- * @brief Transmits data using the FTP protocol.
- * @param handle Pointer to the initialized FTP handle.
- * @param transfer_config Pointer to the transfer configuration structure.
- * @param callback Source callback function to provide data.
- * @param user_data User-defined data passed to the callback.
- * @return Status code indicating the result of the transmission.
+ * @brief Creates a stream socket and connects it to the FTP service of a node.
+ * @param dst_node Destination node ID.
+ * @param socket Pointer to store the connected socket.
+ * @return Status code.
  */
-danp_ftp_status_t danp_ftp_transmit(
-    danp_ftp_handle_t *handle,
-    const danp_ftp_transfer_config_t *transfer_config,
-    danp_ftp_source_cb_t callback,
-    void *user_data)
+danp_ftp_status_t danp_ftp_connect_socket(
+    uint16_t dst_node,
+    danp_socket_t **socket)
 {
     danp_ftp_status_t status = DANP_FTP_STATUS_OK;
-    danp_ftp_message_t response;
-    uint8_t command_payload[128];
-    size_t command_len;
-    uint8_t chunk_buffer[DANP_FTP_MAX_PAYLOAD_SIZE];
-    uint16_t chunk_size;
-    uint32_t timeout_ms;
-    uint8_t max_retries;
-    size_t offset = 0;
-    uint8_t more = 1;
-    uint8_t retries;
-    uint8_t flags;
+    danp_socket_t *sock = NULL;
+    int32_t connect_result;
 
     for (;;)
     {
-        if (!handle || !transfer_config || !callback)
+        if (!socket)
         {
             status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
         }
 
-        if (!handle->is_initialized)
+        sock = danp_socket(DANP_TYPE_STREAM);
+        if (!sock)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP handle not initialized");
+            DANP_FTP_LOG_ERR("FTP failed to create socket");
             status = DANP_FTP_STATUS_ERROR;
             break;
         }
 
-        if (!transfer_config->file_id || transfer_config->file_id_len == 0)
+        connect_result = danp_connect(sock, dst_node, DANP_FTP_PORT);
+        if (connect_result < 0)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP invalid file ID");
-            status = DANP_FTP_STATUS_INVALID_PARAM;
+            DANP_FTP_LOG_ERR(
+                "FTP failed to connect to node %u: %d",
+                dst_node,
+                connect_result);
+            danp_close(sock);
+            status = DANP_FTP_STATUS_CONNECTION_FAILED;
             break;
         }
 
-        chunk_size = transfer_config->chunk_size;
-        if (chunk_size == 0)
-        {
-            chunk_size = DANP_FTP_DEFAULT_CHUNK_SIZE;
-        }
-        if (chunk_size > DANP_FTP_MAX_PAYLOAD_SIZE)
-        {
-            chunk_size = DANP_FTP_MAX_PAYLOAD_SIZE;
-        }
+        *socket = sock;
 
-        timeout_ms = transfer_config->timeout_ms;
-        if (timeout_ms == 0)
-        {
-            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
-        }
+        break;
+    }
 
-        max_retries = transfer_config->max_retries;
-        if (max_retries == 0)
-        {
-            max_retries = DANP_FTP_DEFAULT_MAX_RETRIES;
-        }
+    return status;
+}
 
-        /* Build command payload: [cmd][file_id_len][file_id] */
-        command_payload[0] = DANP_FTP_CMD_REQUEST_WRITE;
-        command_payload[1] = (uint8_t)transfer_config->file_id_len;
-        memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
-        command_len = 2 + transfer_config->file_id_len;
+/**
+ * @brief Initializes an FTP handle around an already connected socket.
+ * @param handle Pointer to the FTP handle to initialize.
+ * @param socket Connected socket.
+ * @param dst_node Destination node ID.
+ */
+void danp_ftp_attach_socket(
+    danp_ftp_handle_t *handle,
+    danp_socket_t *socket,
+    uint16_t dst_node)
+{
+    memset(handle, 0, sizeof(danp_ftp_handle_t));
+
+    handle->socket = socket;
+    handle->dst_node = dst_node;
+    handle->sequence_number = 0;
+    handle->state = DANP_FTP_STATE_IDLE;
+    handle->total_bytes_transferred = 0;
+    handle->workspace = danp_ftp_workspace_claim();
+    handle->is_initialized = true;
+}
 
-        handle->sequence_number = 0;
-        handle->state = DANP_FTP_STATE_CONNECTING;
+/**
+ * @brief Tells whether the transfer running on a handle was cancelled.
+ * @param handle Pointer to the FTP handle.
+ * @return true if the transfer must stop.
+ */
+bool danp_ftp_is_cancelled(const danp_ftp_handle_t *handle)
+{
+    return __atomic_load_n(&handle->is_cancelled, __ATOMIC_ACQUIRE);
+}
 
-        /* Send write request command */
-        status = danp_ftp_send_message(
-            handle,
-            DANP_FTP_PACKET_TYPE_COMMAND,
-            DANP_FTP_FLAG_NONE,
-            command_payload,
-            (uint16_t)command_len);
+/**
+ * @brief Invokes the progress callback of a handle if its interval has elapsed.
+ * @param handle Pointer to the FTP handle.
+ * @param is_final Report regardless of the interval.
+ */
+void danp_ftp_progress_report(danp_ftp_handle_t *handle, bool is_final)
+{
+    uint64_t now_us;
 
-        if (status < 0)
-        {
-            break;
-        }
+    if (handle->progress_callback)
+    {
+        now_us = danp_ftp_port_time_us();
 
-        /* Wait for response */
-        status = danp_ftp_receive_message(handle, &response, timeout_ms);
-        if (status < 0)
+        if (is_final || now_us - handle->progress_last_us >= handle->progress_interval_us)
         {
-            break;
+            handle->progress_last_us = now_us;
+            handle->progress_callback(
+                handle,
+                handle->total_bytes_transferred,
+                handle->progress_user_data);
         }
+    }
+}
 
-        if (response.header.type != DANP_FTP_PACKET_TYPE_RESPONSE)
+/**
+ * @brief Claims a workspace from the static pool.
+ * @return Pointer to the workspace, NULL if the pool is exhausted or disabled.
+ */
+danp_ftp_workspace_t *danp_ftp_workspace_claim(void)
+{
+    danp_ftp_workspace_t *workspace = NULL;
+#if defined(CONFIG_DANP_FTP_STATIC_WORKSPACE) && (DANP_FTP_WORKSPACE_POOL_SIZE > 0)
+    size_t i;
+
+    for (i = 0; i < DANP_FTP_WORKSPACE_POOL_SIZE; i++)
+    {
+        if (!__atomic_exchange_n(&WorkspacePoolClaimed[i], true, __ATOMIC_ACQUIRE))
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_ERR,
-                "FTP unexpected response type: %u",
-                response.header.type);
-            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            workspace = &WorkspacePool[i];
             break;
         }
+    }
 
-        if (response.payload[0] != DANP_FTP_RESP_OK)
+    if (!workspace)
+    {
+        DANP_FTP_LOG_WRN("FTP static workspace pool exhausted");
+    }
+#endif
+
+    return workspace;
+}
+
+/**
+ * @brief Detaches the workspace of a handle, returning it to the static pool if it came from it.
+ * @param handle Pointer to the FTP handle.
+ */
+void danp_ftp_workspace_release(danp_ftp_handle_t *handle)
+{
+#if defined(CONFIG_DANP_FTP_STATIC_WORKSPACE) && (DANP_FTP_WORKSPACE_POOL_SIZE > 0)
+    size_t i;
+
+    for (i = 0; i < DANP_FTP_WORKSPACE_POOL_SIZE; i++)
+    {
+        if (handle->workspace == &WorkspacePool[i])
+        {
+            __atomic_store_n(&WorkspacePoolClaimed[i], false, __ATOMIC_RELEASE);
+            break;
+        }
+    }
+#endif
+
+    handle->workspace = NULL;
+}
+
+/**
+ * @brief Selects the workspace of a transfer.
+ * @param handle Pointer to the FTP handle.
+ * @param fallback Workspace to use if none is attached, may be NULL.
+ * @return The workspace, or NULL if there is none.
+ */
+danp_ftp_workspace_t *danp_ftp_workspace_select(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *fallback)
+{
+    danp_ftp_workspace_t *workspace = handle->workspace ? handle->workspace : fallback;
+
+    if (!workspace)
+    {
+        DANP_FTP_LOG_ERR("FTP handle has no workspace");
+    }
+
+    return workspace;
+}
+
+/**
+ * @brief Initializes the FTP handle for communication with a destination node.
+ * @param handle Pointer to the FTP handle to initialize.
+ * @param dst_node Destination node ID.
+ * @return Status code indicating the result of the initialization.
+ */
+danp_ftp_status_t danp_ftp_init(
+    danp_ftp_handle_t *handle,
+    uint16_t dst_node)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_socket_t *sock = NULL;
+
+    for (;;)
+    {
+        if (!handle)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(handle, 0, sizeof(danp_ftp_handle_t));
+
+        status = danp_ftp_connect_socket(dst_node, &sock);
+        if (status < 0)
+        {
+            break;
+        }
+
+        danp_ftp_attach_socket(handle, sock, dst_node);
+
+        DANP_FTP_LOG_INF(
+            "FTP initialized for node %u",
+            dst_node);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Deinitializes the FTP handle and releases associated resources.
+ * @param handle Pointer to the FTP handle to deinitialize.
+ */
+void danp_ftp_deinit(danp_ftp_handle_t *handle)
+{
+    for (;;)
+    {
+        if (!handle)
+        {
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            break;
+        }
+
+        if (handle->socket)
+        {
+            danp_close(handle->socket);
+            handle->socket = NULL;
+        }
+
+        danp_ftp_workspace_release(handle);
+        handle->is_initialized = false;
+        handle->state = DANP_FTP_STATE_IDLE;
+
+        DANP_FTP_LOG_INF("FTP handle deinitialized");
+
+        break;
+    }
+}
+
+/**
+ * @brief Attaches a caller-owned workspace to an FTP handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param workspace Pointer to the workspace, NULL to detach it.
+ */
+void danp_ftp_set_workspace(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace)
+{
+    if (handle)
+    {
+        danp_ftp_workspace_release(handle);
+        handle->workspace = workspace;
+    }
+}
+
+/**
+ * @brief Cancels the transfer running on an FTP handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_cancel(danp_ftp_handle_t *handle)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    struct
+    {
+        danp_ftp_header_t header;
+        uint8_t payload[1];
+    } PACKED abort_msg;
+    danp_ftp_state_t state;
+
+    for (;;)
+    {
+        if (!handle || !handle->is_initialized || !handle->socket)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        state = __atomic_load_n(&handle->state, __ATOMIC_ACQUIRE);
+        if (state != DANP_FTP_STATE_CONNECTING && state != DANP_FTP_STATE_TRANSFERRING)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Only the first cancel of a transfer sends the ABORT */
+        if (__atomic_exchange_n(&handle->is_cancelled, true, __ATOMIC_ACQ_REL))
+        {
+            break;
+        }
+
+        danp_ftp_schedule_wake(handle);
+
+        /* Built on this thread's stack, the transfer owns the workspace */
+        abort_msg.header.type = DANP_FTP_PACKET_TYPE_COMMAND;
+        abort_msg.header.flags = DANP_FTP_FLAG_NONE;
+        abort_msg.header.sequence_number = 0;
+        abort_msg.header.payload_length = 1;
+        abort_msg.payload[0] = DANP_FTP_CMD_ABORT;
+        abort_msg.header.crc = danp_ftp_calculate_crc(abort_msg.payload, 1);
+
+        if (danp_send(handle->socket, &abort_msg, sizeof(danp_ftp_header_t) + 1) < 0)
+        {
+            DANP_FTP_LOG_WRN("FTP abort send failed");
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        DANP_FTP_LOG_INF("FTP transfer cancelled");
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Sets the progress callback of an FTP handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param callback Progress callback, NULL to disable.
+ * @param interval_ms Minimum time between two reports.
+ * @param user_data User-defined data passed to the callback.
+ */
+void danp_ftp_set_progress(
+    danp_ftp_handle_t *handle,
+    danp_ftp_progress_cb_t callback,
+    uint32_t interval_ms,
+    void *user_data)
+{
+    if (handle)
+    {
+        handle->progress_callback = callback;
+        handle->progress_user_data = user_data;
+        handle->progress_interval_us = (uint64_t)interval_ms * 1000U;
+        handle->progress_last_us = 0;
+    }
+}
+
+/**
+ * @brief Check whether a buffer holds a single repeated byte.
+ *
+ * Compares a machine word at a time against the first byte replicated, a loop compilers turn
+ * into SIMD compares where the target has them.
+ *
+ * @param data Pointer to the data buffer.
+ * @param length Length of the data, must not be 0.
+ * @return true if every byte equals data[0].
+ */
+static bool danp_ftp_is_run(const uint8_t *data, size_t length)
+{
+    uint64_t pattern = (uint64_t)data[0] * 0x0101010101010101ULL;
+    uint64_t difference = 0;
+    uint64_t word;
+    size_t i = 0;
+
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t))
+    {
+        memcpy(&word, &data[i], sizeof(uint64_t));
+        difference |= word ^ pattern;
+    }
+
+    for (; i < length; i++)
+    {
+        difference |= (uint64_t)(data[i] ^ data[0]);
+    }
+
+    return difference == 0;
+}
+
+/**
+ * @brief Send a hole record for a pending run and wait for its ACK.
+ *
+ * The record is built at the head of the outgoing packet, which may hold the chunk that ended
+ * the run; those bytes are parked on the stack meanwhile.
+ *
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer.
+ * @param flags Packet flags.
+ * @param offset Offset of the run.
+ * @param length Length of the run.
+ * @param value Value of the bytes of the run.
+ * @param timeout_ms Timeout in milliseconds.
+ * @param max_retries Maximum number of attempts.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_send_hole(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
+    uint8_t flags,
+    size_t offset,
+    uint32_t length,
+    uint8_t value,
+    uint32_t timeout_ms,
+    uint8_t max_retries)
+{
+    danp_ftp_status_t status;
+    uint8_t *record = DANP_FTP_TX_MESSAGE(workspace)->payload;
+    uint8_t parked[DANP_FTP_HOLE_RECORD_SIZE];
+
+    memcpy(parked, record, DANP_FTP_HOLE_RECORD_SIZE);
+
+    danp_ftp_write_u32_le(record, length);
+    record[4] = value;
+
+    danp_ftp_schedule_begin(handle, offset == 0);
+
+    status = danp_ftp_send_data_reliable(
+        handle,
+        workspace,
+        (uint8_t)(flags | DANP_FTP_FLAG_HOLE | ((offset == 0) ? DANP_FTP_FLAG_FIRST_CHUNK : 0)),
+        record,
+        DANP_FTP_HOLE_RECORD_SIZE,
+        timeout_ms,
+        max_retries);
+
+    danp_ftp_schedule_end(handle);
+
+    memcpy(record, parked, DANP_FTP_HOLE_RECORD_SIZE);
+
+    if (status >= 0)
+    {
+        handle->total_bytes_transferred = offset + length;
+        handle->sequence_number++;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Transmits data using the FTP protocol.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param callback Source callback function to provide data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Status code indicating the result of the transmission.
+ */
+danp_ftp_status_t danp_ftp_transmit(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_transfer_config_t *transfer_config,
+    danp_ftp_source_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    uint8_t *command_payload;
+    size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+    uint8_t *chunk_buffer;
+    uint16_t chunk_size;
+    uint32_t timeout_ms;
+    uint8_t max_retries;
+    size_t offset = 0;
+    uint8_t more = 1;
+    uint8_t flags;
+    uint8_t options = DANP_FTP_OPT_NONE;
+    bool is_run;
+    bool is_run_pending = false;
+    size_t run_offset = 0;
+    uint32_t run_length = 0;
+    uint8_t run_value = 0;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle || !transfer_config || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (!transfer_config->file_id || transfer_config->file_id_len == 0 ||
+            transfer_config->file_id_len > DANP_FTP_MAX_REQUEST_FILE_ID_LEN)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid file ID");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        chunk_size = transfer_config->chunk_size;
+        if (chunk_size == 0)
+        {
+            chunk_size = DANP_FTP_DEFAULT_CHUNK_SIZE;
+        }
+        if (chunk_size > DANP_FTP_MAX_PAYLOAD_SIZE)
+        {
+            chunk_size = DANP_FTP_MAX_PAYLOAD_SIZE;
+        }
+
+        timeout_ms = transfer_config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        max_retries = transfer_config->max_retries;
+        if (max_retries == 0)
+        {
+            max_retries = DANP_FTP_DEFAULT_MAX_RETRIES;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Commands and chunks are built in place in the outgoing packet */
+        command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+        chunk_buffer = DANP_FTP_TX_MESSAGE(workspace)->payload;
+
+        /* Build command payload: [cmd][file_id_len][file_id]([options]) */
+        command_payload[0] = DANP_FTP_CMD_REQUEST_WRITE;
+        command_payload[1] = (uint8_t)transfer_config->file_id_len;
+        memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
+        command_len = 2 + transfer_config->file_id_len;
+        if (transfer_config->verify_digest)
+        {
+            options |= DANP_FTP_OPT_DIGEST;
+            danp_ftp_sha256_init(&workspace->digest);
+        }
+        if (transfer_config->elide_runs)
+        {
+            options |= DANP_FTP_OPT_HOLES;
+        }
+        if (options != DANP_FTP_OPT_NONE)
+        {
+            command_payload[command_len++] = options;
+        }
+
+        /* Send write request command */
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP write request rejected: %u",
+                response_code);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_TRANSFERRING;
+        handle->total_bytes_transferred = 0;
+        handle->sequence_number++;
+
+        DANP_FTP_LOG_INF("FTP transmit started");
+
+        /* Transfer data chunks */
+        while (more)
+        {
+            danp_ftp_status_t read_result = callback(
+                handle,
+                offset,
+                chunk_buffer,
+                chunk_size,
+                &more,
+                user_data);
+
+            if (read_result < 0)
+            {
+                DANP_FTP_LOG_ERR(
+                    "FTP source callback failed: %d",
+                    read_result);
+                status = read_result;
+                break;
+            }
+
+            /* A source that runs dry after promising more still owes the peer a last chunk */
+            if (read_result == 0)
+            {
+                more = 0;
+            }
+
+            /* Hashed once as it leaves the source, retries do not touch the digest */
+            if (transfer_config->verify_digest)
+            {
+                danp_ftp_sha256_update(&workspace->digest, chunk_buffer, (size_t)read_result);
+            }
+
+            is_run = transfer_config->elide_runs &&
+                     read_result > DANP_FTP_HOLE_RECORD_SIZE &&
+                     danp_ftp_is_run(chunk_buffer, (size_t)read_result);
+
+            /* A run ends at a chunk that does not continue it */
+            if (is_run_pending &&
+                (!is_run || chunk_buffer[0] != run_value ||
+                 (uint32_t)read_result > UINT32_MAX - run_length))
+            {
+                status = danp_ftp_send_hole(
+                    handle,
+                    workspace,
+                    DANP_FTP_FLAG_NONE,
+                    run_offset,
+                    run_length,
+                    run_value,
+                    timeout_ms,
+                    max_retries);
+
+                if (status < 0)
+                {
+                    break;
+                }
+
+                is_run_pending = false;
+            }
+
+            if (is_run)
+            {
+                if (!is_run_pending)
+                {
+                    is_run_pending = true;
+                    run_offset = offset;
+                    run_length = 0;
+                    run_value = chunk_buffer[0];
+                }
+
+                run_length += (uint32_t)read_result;
+                offset += read_result;
+                continue;
+            }
+
+            flags = DANP_FTP_FLAG_NONE;
+            if (offset == 0)
+            {
+                flags |= DANP_FTP_FLAG_FIRST_CHUNK;
+            }
+            if (!more)
+            {
+                flags |= DANP_FTP_FLAG_LAST_CHUNK;
+            }
+
+            /* The link is scheduled per chunk, so urgent transfers get in between */
+            danp_ftp_schedule_begin(handle, offset == 0);
+
+            status = danp_ftp_send_data_reliable(
+                handle,
+                workspace,
+                flags,
+                chunk_buffer,
+                (uint16_t)read_result,
+                timeout_ms,
+                max_retries);
+
+            danp_ftp_schedule_end(handle);
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            offset += read_result;
+            handle->total_bytes_transferred = offset;
+            handle->sequence_number++;
+        }
+
+        if (status >= 0 && is_run_pending)
+        {
+            status = danp_ftp_send_hole(
+                handle,
+                workspace,
+                DANP_FTP_FLAG_LAST_CHUNK,
+                run_offset,
+                run_length,
+                run_value,
+                timeout_ms,
+                max_retries);
+        }
+
+        /* The trailer is only acknowledged if the receiver's digest of what it stored matches */
+        if (status >= 0 && transfer_config->verify_digest)
+        {
+            danp_ftp_sha256_final(&workspace->digest, chunk_buffer);
+
+            danp_ftp_schedule_begin(handle, offset == 0);
+
+            status = danp_ftp_send_data_reliable(
+                handle,
+                workspace,
+                DANP_FTP_FLAG_DIGEST,
+                chunk_buffer,
+                DANP_FTP_SHA256_SIZE,
+                timeout_ms,
+                max_retries);
+
+            danp_ftp_schedule_end(handle);
+
+            if (status >= 0)
+            {
+                handle->sequence_number++;
+            }
+        }
+
+        if (status < 0)
+        {
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_COMPLETE;
+
+        DANP_FTP_LOG_INF(
+            "FTP transmit complete: %zu bytes",
+            handle->total_bytes_transferred);
+
+        danp_ftp_progress_report(handle, true);
+
+        status = (danp_ftp_status_t)handle->total_bytes_transferred;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Deliver a received hole record to the hole callback, or expand it for the sink.
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer, holding the record in its incoming packet.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param callback Sink callback function.
+ * @param user_data User-defined data passed to the callbacks.
+ * @param offset Offset of the run.
+ * @param more Set to 1 if more data will follow the run, else 0.
+ * @param length Pointer to store the length of the run.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_deliver_hole(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
+    const danp_ftp_transfer_config_t *transfer_config,
+    danp_ftp_sink_cb_t callback,
+    void *user_data,
+    size_t offset,
+    uint8_t more,
+    size_t *length)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_message_t *record = DANP_FTP_RX_MESSAGE(workspace);
+    uint8_t *fill = record->payload;
+    size_t run_length;
+    size_t done;
+    size_t piece;
+    uint8_t value;
+
+    for (;;)
+    {
+        if (record->header.payload_length != DANP_FTP_HOLE_RECORD_SIZE)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid hole record");
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        run_length = danp_ftp_read_u32_le(fill);
+        value = fill[4];
+
+        /* The record is consumed, its buffer becomes the fill pattern for the expansion */
+        piece = (run_length < DANP_FTP_MAX_PAYLOAD_SIZE) ? run_length : DANP_FTP_MAX_PAYLOAD_SIZE;
+        memset(fill, value, piece);
+
+        if (transfer_config->verify_digest || !transfer_config->hole_callback)
+        {
+            for (done = 0; done < run_length; done += piece)
+            {
+                piece = run_length - done;
+                if (piece > DANP_FTP_MAX_PAYLOAD_SIZE)
+                {
+                    piece = DANP_FTP_MAX_PAYLOAD_SIZE;
+                }
+
+                if (transfer_config->verify_digest)
+                {
+                    danp_ftp_sha256_update(&workspace->digest, fill, piece);
+                }
+
+                if (!transfer_config->hole_callback)
+                {
+                    status = callback(
+                        handle,
+                        offset + done,
+                        fill,
+                        (uint16_t)piece,
+                        (more || done + piece < run_length) ? 1 : 0,
+                        user_data);
+
+                    if (status < 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            if (status < 0)
+            {
+                break;
+            }
+        }
+
+        if (transfer_config->hole_callback)
+        {
+            status = transfer_config->hole_callback(
+                handle,
+                offset,
+                run_length,
+                value,
+                more,
+                user_data);
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            /* A file ending in a run still tells the sink it is complete, so it can flush */
+            if (!more)
+            {
+                status = callback(handle, offset + run_length, fill, 0, 0, user_data);
+                if (status < 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        *length = run_length;
+        status = DANP_FTP_STATUS_OK;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Receive the digest trailer of a transfer and check it against the local digest.
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer, holding the digest of the chunks passed to the sink.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_receive_digest(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
+    uint32_t timeout_ms)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_message_t *trailer = DANP_FTP_RX_MESSAGE(workspace);
+    uint8_t *expected = DANP_FTP_TX_MESSAGE(workspace)->payload;
+
+    /* Only empty ACKs and NACKs go out from here on, so the outgoing payload is free */
+    danp_ftp_sha256_final(&workspace->digest, expected);
+
+    for (;;)
+    {
+        status = danp_ftp_receive_message(handle, trailer, timeout_ms);
+        if (status < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP digest not received");
+            break;
+        }
+
+        if (trailer->header.type != DANP_FTP_PACKET_TYPE_DATA ||
+            trailer->header.sequence_number != handle->sequence_number ||
+            !(trailer->header.flags & DANP_FTP_FLAG_DIGEST) ||
+            trailer->header.payload_length != DANP_FTP_SHA256_SIZE)
+        {
+            DANP_FTP_LOG_WRN(
+                "FTP unexpected packet: type=%u seq=%u",
+                trailer->header.type,
+                trailer->header.sequence_number);
+
+            danp_ftp_send_message(
+                handle,
+                workspace,
+                DANP_FTP_PACKET_TYPE_NACK,
+                DANP_FTP_FLAG_NONE,
+                NULL,
+                0);
+            continue;
+        }
+
+        /* A mismatch is final: the data already went to the sink, so a resend cannot fix it */
+        if (memcmp(trailer->payload, expected, DANP_FTP_SHA256_SIZE) != 0)
+        {
+            DANP_FTP_LOG_ERR("FTP file digest mismatch");
+
+            danp_ftp_send_message(
+                handle,
+                workspace,
+                DANP_FTP_PACKET_TYPE_NACK,
+                DANP_FTP_FLAG_DIGEST,
+                NULL,
+                0);
+            status = DANP_FTP_STATUS_DIGEST_MISMATCH;
+            break;
+        }
+
+        status = danp_ftp_send_message(
+            handle,
+            workspace,
+            DANP_FTP_PACKET_TYPE_ACK,
+            DANP_FTP_FLAG_NONE,
+            NULL,
+            0);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        handle->sequence_number++;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Receives data using the FTP protocol.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param callback Sink callback function to process received data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Status code indicating the result of the reception.
+ */
+danp_ftp_status_t danp_ftp_receive(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_transfer_config_t *transfer_config,
+    danp_ftp_sink_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    danp_ftp_message_t *data_msg;
+    uint8_t *command_payload;
+    size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+    uint32_t timeout_ms;
+    size_t offset = 0;
+    uint8_t more = 1;
+    uint8_t options = DANP_FTP_OPT_NONE;
+    size_t chunk_length;
+    danp_ftp_status_t sink_result;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle || !transfer_config || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (!transfer_config->file_id || transfer_config->file_id_len == 0 ||
+            transfer_config->file_id_len > DANP_FTP_MAX_REQUEST_FILE_ID_LEN)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid file ID");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        timeout_ms = transfer_config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+        data_msg = DANP_FTP_RX_MESSAGE(workspace);
+
+        /* Build command payload: [cmd][file_id_len][file_id]([options]) */
+        command_payload[0] = DANP_FTP_CMD_REQUEST_READ;
+        command_payload[1] = (uint8_t)transfer_config->file_id_len;
+        memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
+        command_len = 2 + transfer_config->file_id_len;
+        if (transfer_config->verify_digest)
+        {
+            options |= DANP_FTP_OPT_DIGEST;
+            danp_ftp_sha256_init(&workspace->digest);
+        }
+        if (transfer_config->elide_runs)
+        {
+            options |= DANP_FTP_OPT_HOLES;
+        }
+        if (options != DANP_FTP_OPT_NONE)
+        {
+            command_payload[command_len++] = options;
+        }
+
+        /* Send read request command */
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response_code == DANP_FTP_RESP_FILE_NOT_FOUND)
+        {
+            DANP_FTP_LOG_ERR("FTP file not found");
+            status = DANP_FTP_STATUS_FILE_NOT_FOUND;
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP read request rejected: %u",
+                response_code);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_TRANSFERRING;
+        handle->total_bytes_transferred = 0;
+        handle->sequence_number++;
+
+        DANP_FTP_LOG_INF("FTP receive started");
+
+        /* Receive data chunks */
+        while (more)
+        {
+            status = danp_ftp_receive_message(handle, data_msg, timeout_ms);
+            if (status < 0)
+            {
+                DANP_FTP_LOG_ERR("FTP receive data failed");
+                break;
+            }
+
+            if (data_msg->header.type != DANP_FTP_PACKET_TYPE_DATA)
+            {
+                DANP_FTP_LOG_WRN(
+                    "FTP unexpected packet type: %u",
+                    data_msg->header.type);
+
+                /* Send NACK */
+                danp_ftp_send_message(
+                    handle,
+                    workspace,
+                    DANP_FTP_PACKET_TYPE_NACK,
+                    DANP_FTP_FLAG_NONE,
+                    NULL,
+                    0);
+                continue;
+            }
+
+            if (data_msg->header.sequence_number != handle->sequence_number)
+            {
+                DANP_FTP_LOG_WRN(
+                    "FTP seq mismatch: expected=%u got=%u",
+                    handle->sequence_number,
+                    data_msg->header.sequence_number);
+
+                /* Send NACK */
+                danp_ftp_send_message(
+                    handle,
+                    workspace,
+                    DANP_FTP_PACKET_TYPE_NACK,
+                    DANP_FTP_FLAG_NONE,
+                    NULL,
+                    0);
+                continue;
+            }
+
+            more = (data_msg->header.flags & DANP_FTP_FLAG_LAST_CHUNK) ? 0 : 1;
+
+            /* Holding the ACK holds the sender, which is how a receiver yields the link */
+            danp_ftp_schedule_begin(handle, offset == 0);
+
+            if (data_msg->header.flags & DANP_FTP_FLAG_HOLE)
+            {
+                sink_result = danp_ftp_deliver_hole(
+                    handle,
+                    workspace,
+                    transfer_config,
+                    callback,
+                    user_data,
+                    offset,
+                    more,
+                    &chunk_length);
+            }
+            else
+            {
+                chunk_length = data_msg->header.payload_length;
+
+                /* Hashed as it reaches the sink, so the trailer check needs no second pass */
+                if (transfer_config->verify_digest)
+                {
+                    danp_ftp_sha256_update(&workspace->digest, data_msg->payload, chunk_length);
+                }
+
+                /* Process received data */
+                sink_result = callback(
+                    handle,
+                    offset,
+                    data_msg->payload,
+                    (uint16_t)chunk_length,
+                    more,
+                    user_data);
+            }
+
+            if (sink_result < 0)
+            {
+                DANP_FTP_LOG_ERR(
+                    "FTP sink callback failed: %d",
+                    sink_result);
+                danp_ftp_schedule_end(handle);
+                status = sink_result;
+                break;
+            }
+
+            /* Send ACK */
+            status = danp_ftp_send_message(
+                handle,
+                workspace,
+                DANP_FTP_PACKET_TYPE_ACK,
+                DANP_FTP_FLAG_NONE,
+                NULL,
+                0);
+
+            danp_ftp_schedule_end(handle);
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            offset += chunk_length;
+            handle->total_bytes_transferred = offset;
+            handle->sequence_number++;
+        }
+
+        if (status >= 0 && transfer_config->verify_digest)
+        {
+            status = danp_ftp_receive_digest(handle, workspace, timeout_ms);
+        }
+
+        if (status < 0)
+        {
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_COMPLETE;
+
+        DANP_FTP_LOG_INF(
+            "FTP receive complete: %zu bytes",
+            handle->total_bytes_transferred);
+
+        danp_ftp_progress_report(handle, true);
+
+        status = (danp_ftp_status_t)handle->total_bytes_transferred;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Receives several files back-to-back in a single batch session.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param batch_config Pointer to the batch configuration structure.
+ * @param callback Batch sink callback function to process received data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Status code indicating the result of the reception.
+ */
+danp_ftp_status_t danp_ftp_receive_batch(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_batch_config_t *batch_config,
+    danp_ftp_batch_sink_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    danp_ftp_message_t *data_msg;
+    uint8_t *command_payload;
+    size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+    uint32_t timeout_ms;
+    size_t file_index = 0;
+    size_t file_offset = 0;
+    uint8_t more;
+    size_t i;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle || !batch_config || !batch_config->files || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_ERR,
-                "FTP write request rejected: %u",
-                response.payload[0]);
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (batch_config->file_count == 0 ||
+            batch_config->file_count > DANP_FTP_BATCH_MAX_FILES)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP invalid batch size: %zu",
+                batch_config->file_count);
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        timeout_ms = batch_config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+        data_msg = DANP_FTP_RX_MESSAGE(workspace);
+
+        /* Build command payload: [cmd][count]([file_id_len][file_id])... */
+        command_payload[0] = DANP_FTP_CMD_REQUEST_READ_BATCH;
+        command_payload[1] = (uint8_t)batch_config->file_count;
+        command_len = 2;
+
+        for (i = 0; i < batch_config->file_count; i++)
+        {
+            const danp_ftp_file_ref_t *file = &batch_config->files[i];
+
+            if (!file->file_id || file->file_id_len == 0 || file->file_id_len > UINT8_MAX ||
+                command_len + 1 + file->file_id_len > DANP_FTP_MAX_PAYLOAD_SIZE)
+            {
+                DANP_FTP_LOG_ERR("FTP invalid batch file ID: %zu", i);
+                status = DANP_FTP_STATUS_INVALID_PARAM;
+                break;
+            }
+
+            command_payload[command_len] = (uint8_t)file->file_id_len;
+            memcpy(&command_payload[command_len + 1], file->file_id, file->file_id_len);
+            command_len += 1 + file->file_id_len;
+
+            if (batch_config->file_status)
+            {
+                batch_config->file_status[i] = DANP_FTP_STATUS_FILE_NOT_FOUND;
+            }
+        }
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        /* Send batch read request command */
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP batch read request rejected: %u",
+                response_code);
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
         }
@@ -515,90 +1877,121 @@ danp_ftp_status_t danp_ftp_transmit(
         handle->total_bytes_transferred = 0;
         handle->sequence_number++;
 
-        danp_log_message(DANP_LOG_LEVEL_INF, "FTP transmit started");
+        DANP_FTP_LOG_INF(
+            "FTP batch receive started: %zu files",
+            batch_config->file_count);
 
-        /* Transfer data chunks */
-        while (more)
+        /* Receive data chunks of all files on the same sequence */
+        while (file_index < batch_config->file_count)
         {
-            danp_ftp_status_t read_result = callback(
-                handle,
-                offset,
-                chunk_buffer,
-                chunk_size,
-                &more,
-                user_data);
-
-            if (read_result < 0)
+            status = danp_ftp_receive_message(handle, data_msg, timeout_ms);
+            if (status < 0)
             {
-                danp_log_message(
-                    DANP_LOG_LEVEL_ERR,
-                    "FTP source callback failed: %d",
-                    read_result);
-                status = read_result;
+                DANP_FTP_LOG_ERR("FTP receive data failed");
                 break;
             }
 
-            if (read_result == 0)
+            if (data_msg->header.type != DANP_FTP_PACKET_TYPE_DATA ||
+                data_msg->header.sequence_number != handle->sequence_number)
             {
-                more = 0;
+                DANP_FTP_LOG_WRN(
+                    "FTP unexpected packet: type=%u seq=%u expected=%u",
+                    data_msg->header.type,
+                    data_msg->header.sequence_number,
+                    handle->sequence_number);
+
+                /* Send NACK */
+                danp_ftp_send_message(
+                    handle,
+                    workspace,
+                    DANP_FTP_PACKET_TYPE_NACK,
+                    DANP_FTP_FLAG_NONE,
+                    NULL,
+                    0);
                 continue;
             }
 
-            flags = DANP_FTP_FLAG_NONE;
-            if (offset == 0)
-            {
-                flags |= DANP_FTP_FLAG_FIRST_CHUNK;
-            }
-            if (!more)
+            if ((data_msg->header.flags & DANP_FTP_FLAG_FIRST_CHUNK) && file_offset != 0)
             {
-                flags |= DANP_FTP_FLAG_LAST_CHUNK;
+                DANP_FTP_LOG_ERR(
+                    "FTP batch file %zu restarted at offset %zu",
+                    file_index,
+                    file_offset);
+                status = DANP_FTP_STATUS_TRANSFER_FAILED;
+                break;
             }
 
-            retries = 0;
-            while (retries < max_retries)
+            more = (data_msg->header.flags & DANP_FTP_FLAG_LAST_CHUNK) ? 0 : 1;
+
+            if (data_msg->header.flags & DANP_FTP_FLAG_FILE_MISSING)
             {
-                status = danp_ftp_send_message(
-                    handle,
-                    DANP_FTP_PACKET_TYPE_DATA,
-                    flags,
-                    chunk_buffer,
-                    (uint16_t)read_result);
+                DANP_FTP_LOG_WRN("FTP batch file %zu not found", file_index);
+                more = 0;
+            }
 
-                if (status < 0)
-                {
-                    retries++;
-                    continue;
-                }
+            /* Holding the ACK holds the sender, which is how a receiver yields the link */
+            danp_ftp_schedule_begin(handle, handle->total_bytes_transferred == 0);
 
-                status = danp_ftp_wait_for_ack(
+            if (!(data_msg->header.flags & DANP_FTP_FLAG_FILE_MISSING))
+            {
+                /* Process received data */
+                danp_ftp_status_t sink_result = callback(
                     handle,
-                    handle->sequence_number,
-                    timeout_ms);
-
-                if (status == DANP_FTP_STATUS_OK)
+                    file_index,
+                    file_offset,
+                    data_msg->payload,
+                    data_msg->header.payload_length,
+                    more,
+                    user_data);
+
+                if (sink_result < 0)
                 {
+                    DANP_FTP_LOG_ERR(
+                        "FTP batch sink callback failed: %d",
+                        sink_result);
+                    danp_ftp_schedule_end(handle);
+                    status = sink_result;
                     break;
                 }
 
-                retries++;
-                danp_log_message(
-                    DANP_LOG_LEVEL_WRN,
-                    "FTP retry %u/%u for seq %u",
-                    retries,
-                    max_retries,
-                    handle->sequence_number);
+                file_offset += data_msg->header.payload_length;
+                handle->total_bytes_transferred += data_msg->header.payload_length;
             }
 
-            if (retries >= max_retries)
+            /* Send ACK */
+            status = danp_ftp_send_message(
+                handle,
+                workspace,
+                DANP_FTP_PACKET_TYPE_ACK,
+                DANP_FTP_FLAG_NONE,
+                NULL,
+                0);
+
+            danp_ftp_schedule_end(handle);
+
+            if (status < 0)
             {
-                danp_log_message(DANP_LOG_LEVEL_ERR, "FTP max retries exceeded");
-                status = DANP_FTP_STATUS_TRANSFER_FAILED;
                 break;
             }
 
-            offset += read_result;
-            handle->total_bytes_transferred = offset;
             handle->sequence_number++;
+
+            if (!more)
+            {
+                if (batch_config->file_status &&
+                    !(data_msg->header.flags & DANP_FTP_FLAG_FILE_MISSING))
+                {
+                    batch_config->file_status[file_index] = (danp_ftp_status_t)file_offset;
+                }
+
+                file_index++;
+                file_offset = 0;
+
+                if (data_msg->header.flags & DANP_FTP_FLAG_LAST_FILE)
+                {
+                    break;
+                }
+            }
         }
 
         if (status < 0)
@@ -609,11 +2002,13 @@ danp_ftp_status_t danp_ftp_transmit(
 
         handle->state = DANP_FTP_STATE_COMPLETE;
 
-        danp_log_message(
-            DANP_LOG_LEVEL_INF,
-            "FTP transmit complete: %zu bytes",
+        DANP_FTP_LOG_INF(
+            "FTP batch receive complete: %zu files, %zu bytes",
+            file_index,
             handle->total_bytes_transferred);
 
+        danp_ftp_progress_report(handle, true);
+
         status = (danp_ftp_status_t)handle->total_bytes_transferred;
 
         break;
@@ -623,27 +2018,31 @@ danp_ftp_status_t danp_ftp_transmit(
 }
 
 /**
- * @brief Receives data using the FTP protocol.
+ * @brief Requests the remote file manifest.
  * @param handle Pointer to the initialized FTP handle.
  * @param transfer_config Pointer to the transfer configuration structure.
- * @param callback Sink callback function to process received data.
+ * @param callback List callback function invoked for each manifest entry.
  * @param user_data User-defined data passed to the callback.
- * @return Status code indicating the result of the reception.
+ * @return Number of entries received or negative status code.
  */
-danp_ftp_status_t danp_ftp_receive(
+danp_ftp_status_t danp_ftp_list(
     danp_ftp_handle_t *handle,
     const danp_ftp_transfer_config_t *transfer_config,
-    danp_ftp_sink_cb_t callback,
+    danp_ftp_list_cb_t callback,
     void *user_data)
 {
     danp_ftp_status_t status = DANP_FTP_STATUS_OK;
-    danp_ftp_message_t response;
-    danp_ftp_message_t data_msg;
-    uint8_t command_payload[128];
+    danp_ftp_workspace_t *workspace = NULL;
+    danp_ftp_message_t *data_msg;
+    danp_ftp_manifest_entry_t entry;
+    uint8_t *command_payload;
     size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
     uint32_t timeout_ms;
-    size_t offset = 0;
+    size_t entry_count = 0;
+    size_t position;
     uint8_t more = 1;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
 
     for (;;)
     {
@@ -655,14 +2054,16 @@ danp_ftp_status_t danp_ftp_receive(
 
         if (!handle->is_initialized)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP handle not initialized");
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
             status = DANP_FTP_STATUS_ERROR;
             break;
         }
 
-        if (!transfer_config->file_id || transfer_config->file_id_len == 0)
+        if (transfer_config->file_id_len > UINT8_MAX ||
+            transfer_config->file_id_len > DANP_FTP_MAX_PAYLOAD_SIZE - 2 ||
+            (!transfer_config->file_id && transfer_config->file_id_len > 0))
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP invalid file ID");
+            DANP_FTP_LOG_ERR("FTP invalid list filter");
             status = DANP_FTP_STATUS_INVALID_PARAM;
             break;
         }
@@ -673,58 +2074,44 @@ danp_ftp_status_t danp_ftp_receive(
             timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
         }
 
-        /* Build command payload: [cmd][file_id_len][file_id] */
-        command_payload[0] = DANP_FTP_CMD_REQUEST_READ;
-        command_payload[1] = (uint8_t)transfer_config->file_id_len;
-        memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
-        command_len = 2 + transfer_config->file_id_len;
-
-        handle->sequence_number = 0;
-        handle->state = DANP_FTP_STATE_CONNECTING;
-
-        /* Send read request command */
-        status = danp_ftp_send_message(
-            handle,
-            DANP_FTP_PACKET_TYPE_COMMAND,
-            DANP_FTP_FLAG_NONE,
-            command_payload,
-            (uint16_t)command_len);
-
-        if (status < 0)
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
         {
+            status = DANP_FTP_STATUS_ERROR;
             break;
         }
 
-        /* Wait for response */
-        status = danp_ftp_receive_message(handle, &response, timeout_ms);
-        if (status < 0)
-        {
-            break;
-        }
+        command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+        data_msg = DANP_FTP_RX_MESSAGE(workspace);
 
-        if (response.header.type != DANP_FTP_PACKET_TYPE_RESPONSE)
+        /* Build command payload: [cmd][prefix_len][prefix] */
+        command_payload[0] = DANP_FTP_CMD_LIST;
+        command_payload[1] = (uint8_t)transfer_config->file_id_len;
+        if (transfer_config->file_id_len > 0)
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_ERR,
-                "FTP unexpected response type: %u",
-                response.header.type);
-            status = DANP_FTP_STATUS_TRANSFER_FAILED;
-            break;
+            memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
         }
+        command_len = 2 + transfer_config->file_id_len;
+
+        /* Send list command */
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
 
-        if (response.payload[0] == DANP_FTP_RESP_FILE_NOT_FOUND)
+        if (status < 0)
         {
-            danp_log_message(DANP_LOG_LEVEL_ERR, "FTP file not found");
-            status = DANP_FTP_STATUS_FILE_NOT_FOUND;
             break;
         }
 
-        if (response.payload[0] != DANP_FTP_RESP_OK)
+        if (response_code != DANP_FTP_RESP_OK)
         {
-            danp_log_message(
-                DANP_LOG_LEVEL_ERR,
-                "FTP read request rejected: %u",
-                response.payload[0]);
+            DANP_FTP_LOG_ERR(
+                "FTP list request rejected: %u",
+                response_code);
             status = DANP_FTP_STATUS_TRANSFER_FAILED;
             break;
         }
@@ -733,28 +2120,29 @@ danp_ftp_status_t danp_ftp_receive(
         handle->total_bytes_transferred = 0;
         handle->sequence_number++;
 
-        danp_log_message(DANP_LOG_LEVEL_INF, "FTP receive started");
-
-        /* Receive data chunks */
+        /* Receive manifest chunks; entries never straddle two packets */
         while (more)
         {
-            status = danp_ftp_receive_message(handle, &data_msg, timeout_ms);
+            status = danp_ftp_receive_message(handle, data_msg, timeout_ms);
             if (status < 0)
             {
-                danp_log_message(DANP_LOG_LEVEL_ERR, "FTP receive data failed");
+                DANP_FTP_LOG_ERR("FTP receive manifest failed");
                 break;
             }
 
-            if (data_msg.header.type != DANP_FTP_PACKET_TYPE_DATA)
+            if (data_msg->header.type != DANP_FTP_PACKET_TYPE_DATA ||
+                data_msg->header.sequence_number != handle->sequence_number)
             {
-                danp_log_message(
-                    DANP_LOG_LEVEL_WRN,
-                    "FTP unexpected packet type: %u",
-                    data_msg.header.type);
+                DANP_FTP_LOG_WRN(
+                    "FTP unexpected packet: type=%u seq=%u expected=%u",
+                    data_msg->header.type,
+                    data_msg->header.sequence_number,
+                    handle->sequence_number);
 
                 /* Send NACK */
                 danp_ftp_send_message(
                     handle,
+                    workspace,
                     DANP_FTP_PACKET_TYPE_NACK,
                     DANP_FTP_FLAG_NONE,
                     NULL,
@@ -762,48 +2150,51 @@ danp_ftp_status_t danp_ftp_receive(
                 continue;
             }
 
-            if (data_msg.header.sequence_number != handle->sequence_number)
+            more = (data_msg->header.flags & DANP_FTP_FLAG_LAST_CHUNK) ? 0 : 1;
+
+            /* Entry layout: [file_id_len][file_id][size][mtime][checksum] */
+            position = 0;
+            while (position < data_msg->header.payload_length)
             {
-                danp_log_message(
-                    DANP_LOG_LEVEL_WRN,
-                    "FTP seq mismatch: expected=%u got=%u",
-                    handle->sequence_number,
-                    data_msg.header.sequence_number);
+                const uint8_t *record = &data_msg->payload[position];
+                size_t id_len = record[0];
 
-                /* Send NACK */
-                danp_ftp_send_message(
-                    handle,
-                    DANP_FTP_PACKET_TYPE_NACK,
-                    DANP_FTP_FLAG_NONE,
-                    NULL,
-                    0);
-                continue;
-            }
+                if (id_len == 0 || id_len > DANP_FTP_MAX_FILE_ID_LEN ||
+                    position + DANP_FTP_MANIFEST_ENTRY_FIXED_SIZE + id_len >
+                        data_msg->header.payload_length)
+                {
+                    DANP_FTP_LOG_ERR("FTP malformed manifest entry");
+                    status = DANP_FTP_STATUS_TRANSFER_FAILED;
+                    break;
+                }
 
-            more = (data_msg.header.flags & DANP_FTP_FLAG_LAST_CHUNK) ? 0 : 1;
+                memset(&entry, 0, sizeof(entry));
+                entry.file_id_len = (uint8_t)id_len;
+                memcpy(entry.file_id, &record[1], id_len);
+                entry.size = danp_ftp_read_u32_le(&record[1 + id_len]);
+                entry.mtime = danp_ftp_read_u32_le(&record[5 + id_len]);
+                entry.checksum = danp_ftp_read_u32_le(&record[9 + id_len]);
 
-            /* Process received data */
-            danp_ftp_status_t sink_result = callback(
-                handle,
-                offset,
-                data_msg.payload,
-                data_msg.header.payload_length,
-                more,
-                user_data);
+                status = callback(handle, &entry, user_data);
+                if (status < 0)
+                {
+                    DANP_FTP_LOG_ERR("FTP list callback failed: %d", status);
+                    break;
+                }
 
-            if (sink_result < 0)
+                position += DANP_FTP_MANIFEST_ENTRY_FIXED_SIZE + id_len;
+                entry_count++;
+            }
+
+            if (status < 0)
             {
-                danp_log_message(
-                    DANP_LOG_LEVEL_ERR,
-                    "FTP sink callback failed: %d",
-                    sink_result);
-                status = sink_result;
                 break;
             }
 
             /* Send ACK */
             status = danp_ftp_send_message(
                 handle,
+                workspace,
                 DANP_FTP_PACKET_TYPE_ACK,
                 DANP_FTP_FLAG_NONE,
                 NULL,
@@ -814,8 +2205,7 @@ danp_ftp_status_t danp_ftp_receive(
                 break;
             }
 
-            offset += data_msg.header.payload_length;
-            handle->total_bytes_transferred = offset;
+            handle->total_bytes_transferred += data_msg->header.payload_length;
             handle->sequence_number++;
         }
 
@@ -827,12 +2217,84 @@ danp_ftp_status_t danp_ftp_receive(
 
         handle->state = DANP_FTP_STATE_COMPLETE;
 
-        danp_log_message(
-            DANP_LOG_LEVEL_INF,
-            "FTP receive complete: %zu bytes",
-            handle->total_bytes_transferred);
+        DANP_FTP_LOG_INF("FTP list complete: %zu entries", entry_count);
 
-        status = (danp_ftp_status_t)handle->total_bytes_transferred;
+        status = (danp_ftp_status_t)entry_count;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Checks that the remote FTP service answers on this handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param timeout_ms Timeout in milliseconds, 0 for the default.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_ping(
+    danp_ftp_handle_t *handle,
+    uint32_t timeout_ms)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    uint8_t command_payload[1];
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        command_payload[0] = DANP_FTP_CMD_PING;
+
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            sizeof(command_payload),
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_WRN("FTP ping rejected: %u", response_code);
+            status = DANP_FTP_STATUS_CONNECTION_FAILED;
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_IDLE;
 
         break;
     }
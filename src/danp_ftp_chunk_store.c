@@ -0,0 +1,430 @@
+/* danp_ftp_chunk_store.c - bounded content-addressed chunk store with LRU eviction */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_chunk_store.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Maps a hash to its bucket.
+ * @param store Pointer to the chunk store.
+ * @param hash SHA-256 of the chunk.
+ * @return Bucket index.
+ */
+static size_t danp_ftp_chunk_store_bucket(
+    const danp_ftp_chunk_store_t *store,
+    const uint8_t *hash)
+{
+    /* SHA-256 output is uniform, any four bytes make a good index */
+    uint32_t key = ((uint32_t)hash[0] << 24) | ((uint32_t)hash[1] << 16) |
+                   ((uint32_t)hash[2] << 8) | (uint32_t)hash[3];
+
+    return key % store->capacity;
+}
+
+/**
+ * @brief Removes an entry from the LRU list.
+ * @param store Pointer to the chunk store.
+ * @param index Entry index.
+ */
+static void danp_ftp_chunk_store_lru_unlink(
+    danp_ftp_chunk_store_t *store,
+    uint16_t index)
+{
+    danp_ftp_chunk_entry_t *entry = &store->entries[index];
+
+    if (entry->lru_prev != DANP_FTP_CHUNK_STORE_NONE)
+    {
+        store->entries[entry->lru_prev].lru_next = entry->lru_next;
+    }
+    else
+    {
+        store->lru_head = entry->lru_next;
+    }
+
+    if (entry->lru_next != DANP_FTP_CHUNK_STORE_NONE)
+    {
+        store->entries[entry->lru_next].lru_prev = entry->lru_prev;
+    }
+    else
+    {
+        store->lru_tail = entry->lru_prev;
+    }
+
+    entry->lru_prev = DANP_FTP_CHUNK_STORE_NONE;
+    entry->lru_next = DANP_FTP_CHUNK_STORE_NONE;
+}
+
+/**
+ * @brief Inserts an entry at the most recently used end of the LRU list.
+ * @param store Pointer to the chunk store.
+ * @param index Entry index.
+ */
+static void danp_ftp_chunk_store_lru_push(
+    danp_ftp_chunk_store_t *store,
+    uint16_t index)
+{
+    danp_ftp_chunk_entry_t *entry = &store->entries[index];
+
+    entry->lru_prev = DANP_FTP_CHUNK_STORE_NONE;
+    entry->lru_next = store->lru_head;
+
+    if (store->lru_head != DANP_FTP_CHUNK_STORE_NONE)
+    {
+        store->entries[store->lru_head].lru_prev = index;
+    }
+    else
+    {
+        store->lru_tail = index;
+    }
+
+    store->lru_head = index;
+}
+
+/**
+ * @brief Finds the entry of a hash, valid or reserved.
+ * @param store Pointer to the chunk store.
+ * @param hash SHA-256 of the chunk.
+ * @return Entry index or DANP_FTP_CHUNK_STORE_NONE.
+ */
+static uint16_t danp_ftp_chunk_store_lookup(
+    const danp_ftp_chunk_store_t *store,
+    const uint8_t *hash)
+{
+    uint16_t index = store->entries[danp_ftp_chunk_store_bucket(store, hash)].bucket_head;
+
+    while (index != DANP_FTP_CHUNK_STORE_NONE)
+    {
+        if (memcmp(store->entries[index].hash, hash, DANP_FTP_SHA256_SIZE) == 0)
+        {
+            break;
+        }
+        index = store->entries[index].bucket_next;
+    }
+
+    return index;
+}
+
+/**
+ * @brief Drops the least recently used entry.
+ * @param store Pointer to the chunk store.
+ * @return Index of the freed entry.
+ */
+static uint16_t danp_ftp_chunk_store_evict(danp_ftp_chunk_store_t *store)
+{
+    uint16_t victim = store->lru_tail;
+    danp_ftp_chunk_entry_t *entry = &store->entries[victim];
+    uint16_t *link = &store->entries[danp_ftp_chunk_store_bucket(store, entry->hash)].bucket_head;
+
+    while (*link != victim)
+    {
+        link = &store->entries[*link].bucket_next;
+    }
+    *link = entry->bucket_next;
+
+    danp_ftp_chunk_store_lru_unlink(store, victim);
+
+    entry->bucket_next = DANP_FTP_CHUNK_STORE_NONE;
+    entry->is_used = false;
+    entry->is_valid = false;
+    store->count--;
+    store->stats.evictions++;
+
+    return victim;
+}
+
+/**
+ * @brief Initializes a chunk store over caller-owned storage.
+ * @param store Pointer to the chunk store to initialize.
+ * @param entries Storage for capacity entries.
+ * @param capacity Number of chunks.
+ * @param data Storage for capacity * chunk_size bytes.
+ * @param chunk_size Largest chunk the store accepts.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_chunk_store_init(
+    danp_ftp_chunk_store_t *store,
+    danp_ftp_chunk_entry_t *entries,
+    size_t capacity,
+    uint8_t *data,
+    uint16_t chunk_size)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t i;
+
+    for (;;)
+    {
+        if (!store || !entries || !data || capacity == 0 ||
+            capacity > DANP_FTP_CHUNK_STORE_MAX_CAPACITY || chunk_size == 0)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(store, 0, sizeof(danp_ftp_chunk_store_t));
+        memset(entries, 0, capacity * sizeof(danp_ftp_chunk_entry_t));
+
+        for (i = 0; i < capacity; i++)
+        {
+            entries[i].lru_prev = DANP_FTP_CHUNK_STORE_NONE;
+            entries[i].lru_next = DANP_FTP_CHUNK_STORE_NONE;
+            entries[i].bucket_head = DANP_FTP_CHUNK_STORE_NONE;
+            entries[i].bucket_next = DANP_FTP_CHUNK_STORE_NONE;
+        }
+
+        store->entries = entries;
+        store->data = data;
+        store->capacity = capacity;
+        store->chunk_size = chunk_size;
+        store->lru_head = DANP_FTP_CHUNK_STORE_NONE;
+        store->lru_tail = DANP_FTP_CHUNK_STORE_NONE;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Looks up a chunk by hash and marks it as recently used.
+ * @param store Pointer to the chunk store.
+ * @param hash SHA-256 of the chunk.
+ * @return Entry index, or DANP_FTP_STATUS_FILE_NOT_FOUND.
+ */
+danp_ftp_status_t danp_ftp_chunk_store_find(
+    danp_ftp_chunk_store_t *store,
+    const uint8_t *hash)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_FILE_NOT_FOUND;
+    uint16_t index;
+
+    for (;;)
+    {
+        if (!store || !hash)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        index = danp_ftp_chunk_store_lookup(store, hash);
+        if (index == DANP_FTP_CHUNK_STORE_NONE || !store->entries[index].is_valid)
+        {
+            store->stats.misses++;
+            break;
+        }
+
+        danp_ftp_chunk_store_lru_unlink(store, index);
+        danp_ftp_chunk_store_lru_push(store, index);
+        store->stats.hits++;
+        status = (danp_ftp_status_t)index;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Reserves an entry for a hash whose data will be filled in later.
+ * @param store Pointer to the chunk store.
+ * @param hash SHA-256 of the chunk.
+ * @return Entry index or negative status code.
+ */
+danp_ftp_status_t danp_ftp_chunk_store_reserve(
+    danp_ftp_chunk_store_t *store,
+    const uint8_t *hash)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_chunk_entry_t *entry;
+    size_t bucket;
+    uint16_t index;
+
+    for (;;)
+    {
+        if (!store || !hash)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        index = danp_ftp_chunk_store_lookup(store, hash);
+        if (index != DANP_FTP_CHUNK_STORE_NONE)
+        {
+            danp_ftp_chunk_store_lru_unlink(store, index);
+            danp_ftp_chunk_store_lru_push(store, index);
+            status = (danp_ftp_status_t)index;
+            break;
+        }
+
+        if (store->count < store->capacity)
+        {
+            /* Entries are handed out in order until the store is full for the first time */
+            index = (uint16_t)store->count;
+        }
+        else
+        {
+            index = danp_ftp_chunk_store_evict(store);
+        }
+
+        entry = &store->entries[index];
+        memcpy(entry->hash, hash, DANP_FTP_SHA256_SIZE);
+        entry->length = 0;
+        entry->is_used = true;
+        entry->is_valid = false;
+
+        bucket = danp_ftp_chunk_store_bucket(store, hash);
+        entry->bucket_next = store->entries[bucket].bucket_head;
+        store->entries[bucket].bucket_head = index;
+
+        danp_ftp_chunk_store_lru_push(store, index);
+        store->count++;
+
+        status = (danp_ftp_status_t)index;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Stores the data of a reserved entry.
+ * @param store Pointer to the chunk store.
+ * @param index Entry index.
+ * @param data Chunk data.
+ * @param length Chunk size.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_chunk_store_fill(
+    danp_ftp_chunk_store_t *store,
+    size_t index,
+    const uint8_t *data,
+    uint16_t length)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_chunk_entry_t *entry;
+
+    for (;;)
+    {
+        if (!store || index >= store->capacity || (!data && length > 0) ||
+            length > store->chunk_size || !store->entries[index].is_used)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        entry = &store->entries[index];
+        if (length > 0)
+        {
+            memcpy(&store->data[index * store->chunk_size], data, length);
+        }
+        entry->length = length;
+        entry->is_valid = true;
+        store->stats.insertions++;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Hashes and stores a chunk.
+ * @param store Pointer to the chunk store.
+ * @param data Chunk data.
+ * @param length Chunk size.
+ * @param hash Buffer for the hash, may be NULL.
+ * @return Entry index or negative status code.
+ */
+danp_ftp_status_t danp_ftp_chunk_store_insert(
+    danp_ftp_chunk_store_t *store,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t *hash)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint8_t digest[DANP_FTP_SHA256_SIZE];
+    danp_ftp_status_t index;
+
+    for (;;)
+    {
+        if (!store || (!data && length > 0) || length > store->chunk_size)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        danp_ftp_sha256(data, length, digest);
+        if (hash)
+        {
+            memcpy(hash, digest, DANP_FTP_SHA256_SIZE);
+        }
+
+        index = danp_ftp_chunk_store_reserve(store, digest);
+        if (index < 0)
+        {
+            status = index;
+            break;
+        }
+
+        if (!store->entries[index].is_valid)
+        {
+            status = danp_ftp_chunk_store_fill(store, (size_t)index, data, length);
+            if (status < 0)
+            {
+                break;
+            }
+        }
+
+        status = index;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Returns the data of a valid entry.
+ * @param store Pointer to the chunk store.
+ * @param index Entry index.
+ * @param length Pointer to store the chunk size.
+ * @return Pointer to the chunk data, or NULL.
+ */
+const uint8_t *danp_ftp_chunk_store_data(
+    const danp_ftp_chunk_store_t *store,
+    size_t index,
+    uint16_t *length)
+{
+    const uint8_t *data = NULL;
+
+    if (store && index < store->capacity && store->entries[index].is_valid)
+    {
+        data = &store->data[index * store->chunk_size];
+        if (length)
+        {
+            *length = store->entries[index].length;
+        }
+    }
+
+    return data;
+}
@@ -0,0 +1,220 @@
+/* danp_ftp_coalesce.c - sink wrapper coalescing chunks into large aligned block writes */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_coalesce.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Initializes a coalescing sink.
+ * @param sink Pointer to the sink to initialize.
+ * @param buffer Block buffer.
+ * @param block_size Size of the block buffer.
+ * @param write Block writer callback.
+ * @param sync Sync callback, may be NULL.
+ * @param writer_data Context passed to the writer callbacks.
+ * @param flags Options.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_coalesce_sink_init(
+    danp_ftp_coalesce_sink_t *sink,
+    uint8_t *buffer,
+    size_t block_size,
+    danp_ftp_block_write_cb_t write,
+    danp_ftp_block_sync_cb_t sync,
+    void *writer_data,
+    uint8_t flags)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!sink || !buffer || block_size == 0 || !write)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(sink, 0, sizeof(danp_ftp_coalesce_sink_t));
+
+        sink->buffer = buffer;
+        sink->block_size = block_size;
+        sink->write = write;
+        sink->sync = sync;
+        sink->writer_data = writer_data;
+        sink->flags = flags;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Writes out buffered data without waiting for the final chunk.
+ * @param sink Pointer to the sink.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_coalesce_sink_flush(danp_ftp_coalesce_sink_t *sink)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!sink)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (sink->fill == 0)
+        {
+            break;
+        }
+
+        status = sink->write(sink->writer_data, sink->base_offset, sink->buffer, sink->fill);
+        if (status != (danp_ftp_status_t)sink->fill)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP block write failed at offset %zu: %d",
+                sink->base_offset,
+                status);
+            status = status < 0 ? status : DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        sink->stats.writes++;
+        sink->stats.bytes_written += sink->fill;
+        sink->base_offset += sink->fill;
+        sink->fill = 0;
+        status = DANP_FTP_STATUS_OK;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Sink callback buffering chunks into blocks.
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset of the chunk.
+ * @param data Chunk data.
+ * @param length Length of the chunk.
+ * @param more Set to 1 if more data will follow.
+ * @param user_data Pointer to a danp_ftp_coalesce_sink_t.
+ * @return Number of bytes consumed or negative status code.
+ */
+danp_ftp_status_t danp_ftp_coalesce_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data)
+{
+    danp_ftp_coalesce_sink_t *sink = (danp_ftp_coalesce_sink_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t consumed = 0;
+    size_t room;
+    size_t block_end;
+
+    (void)handle;
+
+    for (;;)
+    {
+        if (!sink || (!data && length > 0))
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        sink->stats.chunks++;
+
+        /* A gap or rewind ends the current run */
+        if (offset != sink->base_offset + sink->fill)
+        {
+            status = danp_ftp_coalesce_sink_flush(sink);
+            if (status < 0)
+            {
+                break;
+            }
+            sink->base_offset = offset;
+        }
+
+        while (consumed < length)
+        {
+            /* Blocks end on block-size boundaries of the file */
+            block_end = ((sink->base_offset / sink->block_size) + 1U) * sink->block_size;
+            room = block_end - (sink->base_offset + sink->fill);
+            if (room > length - consumed)
+            {
+                room = length - consumed;
+            }
+
+            memcpy(&sink->buffer[sink->fill], &data[consumed], room);
+            sink->fill += room;
+            consumed += room;
+
+            if (sink->base_offset + sink->fill == block_end)
+            {
+                status = danp_ftp_coalesce_sink_flush(sink);
+                if (status < 0)
+                {
+                    break;
+                }
+            }
+        }
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (!more)
+        {
+            status = danp_ftp_coalesce_sink_flush(sink);
+            if (status < 0)
+            {
+                break;
+            }
+
+            if ((sink->flags & DANP_FTP_COALESCE_FLAG_SYNC_ON_FINAL) && sink->sync)
+            {
+                status = sink->sync(sink->writer_data);
+                if (status < 0)
+                {
+                    DANP_FTP_LOG_ERR("FTP block sync failed: %d", status);
+                    break;
+                }
+                sink->stats.syncs++;
+            }
+        }
+
+        status = (danp_ftp_status_t)length;
+
+        break;
+    }
+
+    return status;
+}
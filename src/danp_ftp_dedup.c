@@ -0,0 +1,725 @@
+/* danp_ftp_dedup.c - deduplicated transfers over a content-addressed chunk store */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_dedup.h"
+#include "danp/danp.h"
+#include "danp_ftp_internal.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+/* One slot index byte precedes the chunk in a DATA packet */
+#define DANP_FTP_DEDUP_MAX_CHUNK_SIZE         (DANP_FTP_MAX_PAYLOAD_SIZE - 1U)
+#define DANP_FTP_DEDUP_MAX_FILE_ID_LEN        (DANP_FTP_MAX_PAYLOAD_SIZE - 4U)
+#define DANP_FTP_DEDUP_BITMAP_SIZE            ((DANP_FTP_DEDUP_WINDOW + 7U) / 8U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Returns the number of chunks per window for the configured payload size.
+ * @return Chunks per window.
+ */
+static size_t danp_ftp_dedup_window(void)
+{
+    size_t window = DANP_FTP_MAX_PAYLOAD_SIZE / DANP_FTP_SHA256_SIZE;
+
+    if (window > DANP_FTP_DEDUP_WINDOW)
+    {
+        window = DANP_FTP_DEDUP_WINDOW;
+    }
+
+    return window;
+}
+
+/**
+ * @brief Builds a dedup request command in the outgoing packet and sends it.
+ * @param handle Pointer to the FTP handle.
+ * @param workspace Workspace of the transfer.
+ * @param command Command code.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param chunk_size Chunk size announced to the peer.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_dedup_request(
+    danp_ftp_handle_t *handle,
+    danp_ftp_workspace_t *workspace,
+    uint8_t command,
+    const danp_ftp_transfer_config_t *transfer_config,
+    uint16_t chunk_size,
+    uint32_t timeout_ms)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint8_t *command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+    size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+
+    for (;;)
+    {
+        /* Build command payload: [cmd][file_id_len][file_id][chunk_size u16] */
+        command_payload[0] = command;
+        command_payload[1] = (uint8_t)transfer_config->file_id_len;
+        memcpy(&command_payload[2], transfer_config->file_id, transfer_config->file_id_len);
+        command_len = 2 + transfer_config->file_id_len;
+        danp_ftp_write_u16_le(&command_payload[command_len], chunk_size);
+        command_len += 2;
+
+        status = danp_ftp_exchange_command(
+            handle,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response_code == DANP_FTP_RESP_FILE_NOT_FOUND)
+        {
+            DANP_FTP_LOG_ERR("FTP file not found");
+            status = DANP_FTP_STATUS_FILE_NOT_FOUND;
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP dedup request rejected: %u",
+                response_code);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_TRANSFERRING;
+        handle->total_bytes_transferred = 0;
+        handle->sequence_number++;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Transmits data, sending only the chunks the receiver does not already hold.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param store Chunk store holding the window being sent.
+ * @param callback Source callback function to provide data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Number of bytes of the file or negative status code.
+ */
+danp_ftp_status_t danp_ftp_transmit_dedup(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_transfer_config_t *transfer_config,
+    danp_ftp_chunk_store_t *store,
+    danp_ftp_source_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    uint16_t slot_index[DANP_FTP_DEDUP_WINDOW];
+    uint8_t missing[DANP_FTP_DEDUP_BITMAP_SIZE];
+    danp_ftp_status_t read_result;
+    danp_ftp_message_t *ack_msg;
+    uint8_t *payload;
+    uint8_t *scratch;
+    const uint8_t *chunk;
+    uint16_t chunk_length;
+    uint16_t chunk_size;
+    uint32_t timeout_ms;
+    uint8_t max_retries;
+    size_t window;
+    size_t count;
+    size_t bitmap_len;
+    size_t i;
+    size_t offset = 0;
+    uint8_t more = 1;
+    uint8_t flags;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle || !transfer_config || !store || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (!transfer_config->file_id || transfer_config->file_id_len == 0 ||
+            transfer_config->file_id_len > DANP_FTP_DEDUP_MAX_FILE_ID_LEN)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid file ID");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        chunk_size = transfer_config->chunk_size;
+        if (chunk_size == 0)
+        {
+            chunk_size = DANP_FTP_DEFAULT_CHUNK_SIZE;
+        }
+        if (chunk_size > DANP_FTP_DEDUP_MAX_CHUNK_SIZE)
+        {
+            chunk_size = DANP_FTP_DEDUP_MAX_CHUNK_SIZE;
+        }
+
+        window = danp_ftp_dedup_window();
+        if (store->capacity < window || store->chunk_size < chunk_size)
+        {
+            DANP_FTP_LOG_ERR("FTP chunk store smaller than one window");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        timeout_ms = transfer_config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        max_retries = transfer_config->max_retries;
+        if (max_retries == 0)
+        {
+            max_retries = DANP_FTP_DEFAULT_MAX_RETRIES;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Hash lists and chunks are built in place; the incoming packet is idle while reading */
+        payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+        ack_msg = DANP_FTP_RX_MESSAGE(workspace);
+        scratch = ack_msg->payload;
+
+        status = danp_ftp_dedup_request(
+            handle,
+            workspace,
+            DANP_FTP_CMD_REQUEST_WRITE_DEDUP,
+            transfer_config,
+            chunk_size,
+            timeout_ms);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        DANP_FTP_LOG_INF("FTP dedup transmit started");
+
+        do
+        {
+            flags = DANP_FTP_FLAG_HASH_LIST;
+            if (offset == 0)
+            {
+                flags |= DANP_FTP_FLAG_FIRST_CHUNK;
+            }
+
+            /* Read and hash one window; the store keeps the chunks until they are asked for */
+            count = 0;
+            while (count < window && more)
+            {
+                read_result = callback(
+                    handle,
+                    offset,
+                    scratch,
+                    chunk_size,
+                    &more,
+                    user_data);
+
+                if (read_result < 0)
+                {
+                    DANP_FTP_LOG_ERR(
+                        "FTP source callback failed: %d",
+                        read_result);
+                    status = read_result;
+                    break;
+                }
+
+                if (read_result == 0)
+                {
+                    more = 0;
+                    break;
+                }
+
+                status = danp_ftp_chunk_store_insert(
+                    store,
+                    scratch,
+                    (uint16_t)read_result,
+                    &payload[count * DANP_FTP_SHA256_SIZE]);
+
+                if (status < 0)
+                {
+                    break;
+                }
+
+                slot_index[count] = (uint16_t)status;
+                offset += read_result;
+                count++;
+            }
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            if (!more)
+            {
+                flags |= DANP_FTP_FLAG_LAST_CHUNK;
+            }
+
+            danp_ftp_schedule_begin(handle, handle->sequence_number == 1);
+
+            /* Advertise the window: [sha256 x count], answered by a bitmap of missing chunks */
+            status = danp_ftp_send_data_reliable(
+                handle,
+                workspace,
+                flags,
+                payload,
+                (uint16_t)(count * DANP_FTP_SHA256_SIZE),
+                timeout_ms,
+                max_retries);
+
+            if (status == DANP_FTP_STATUS_OK)
+            {
+                handle->sequence_number++;
+                bitmap_len = (count + 7U) / 8U;
+                if (ack_msg->header.payload_length < bitmap_len)
+                {
+                    DANP_FTP_LOG_ERR("FTP dedup bitmap too short");
+                    status = DANP_FTP_STATUS_TRANSFER_FAILED;
+                }
+                else
+                {
+                    memcpy(missing, ack_msg->payload, bitmap_len);
+                }
+            }
+
+            danp_ftp_schedule_end(handle);
+
+            /* Send what is missing: [slot u8][data] */
+            for (i = 0; i < count && status == DANP_FTP_STATUS_OK; i++)
+            {
+                if (!(missing[i / 8U] & (1U << (i % 8U))))
+                {
+                    continue;
+                }
+
+                chunk = danp_ftp_chunk_store_data(store, slot_index[i], &chunk_length);
+                if (!chunk)
+                {
+                    status = DANP_FTP_STATUS_ERROR;
+                    break;
+                }
+
+                payload[0] = (uint8_t)i;
+                memcpy(&payload[1], chunk, chunk_length);
+
+                danp_ftp_schedule_begin(handle, false);
+
+                status = danp_ftp_send_data_reliable(
+                    handle,
+                    workspace,
+                    DANP_FTP_FLAG_NONE,
+                    payload,
+                    (uint16_t)(chunk_length + 1U),
+                    timeout_ms,
+                    max_retries);
+
+                danp_ftp_schedule_end(handle);
+
+                if (status == DANP_FTP_STATUS_OK)
+                {
+                    handle->sequence_number++;
+                }
+            }
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            handle->total_bytes_transferred = offset;
+        } while (more);
+
+        if (status < 0)
+        {
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_COMPLETE;
+
+        DANP_FTP_LOG_INF(
+            "FTP dedup transmit complete: %zu bytes",
+            handle->total_bytes_transferred);
+
+        danp_ftp_progress_report(handle, true);
+
+        status = (danp_ftp_status_t)handle->total_bytes_transferred;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Receives data, fetching only the chunks missing from a local chunk store.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param transfer_config Pointer to the transfer configuration structure.
+ * @param store Chunk store to reuse and fill.
+ * @param callback Sink callback function to process received data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Number of bytes of the file or negative status code.
+ */
+danp_ftp_status_t danp_ftp_receive_dedup(
+    danp_ftp_handle_t *handle,
+    const danp_ftp_transfer_config_t *transfer_config,
+    danp_ftp_chunk_store_t *store,
+    danp_ftp_sink_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_workspace_t *workspace = NULL;
+    uint16_t slot_index[DANP_FTP_DEDUP_WINDOW];
+    uint8_t missing[DANP_FTP_DEDUP_BITMAP_SIZE];
+    uint8_t digest[DANP_FTP_SHA256_SIZE];
+    danp_ftp_status_t sink_result;
+    danp_ftp_message_t *data_msg;
+    uint8_t *ack_payload;
+    const uint8_t *chunk;
+    uint16_t chunk_length;
+    uint16_t ack_length;
+    uint32_t timeout_ms;
+    size_t window;
+    size_t count = 0;
+    size_t missing_left = 0;
+    size_t bitmap_len;
+    size_t slot;
+    size_t i;
+    size_t j;
+    size_t offset = 0;
+    bool is_window_open = false;
+    bool is_last = false;
+    bool is_done = false;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!handle || !transfer_config || !store || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!handle->is_initialized)
+        {
+            DANP_FTP_LOG_ERR("FTP handle not initialized");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (!transfer_config->file_id || transfer_config->file_id_len == 0 ||
+            transfer_config->file_id_len > DANP_FTP_DEDUP_MAX_FILE_ID_LEN)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid file ID");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        window = danp_ftp_dedup_window();
+        if (store->capacity < window)
+        {
+            DANP_FTP_LOG_ERR("FTP chunk store smaller than one window");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        timeout_ms = transfer_config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        workspace = danp_ftp_workspace_select(handle, fallback_workspace);
+        if (!workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        data_msg = DANP_FTP_RX_MESSAGE(workspace);
+        ack_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+
+        status = danp_ftp_dedup_request(
+            handle,
+            workspace,
+            DANP_FTP_CMD_REQUEST_READ_DEDUP,
+            transfer_config,
+            (store->chunk_size < DANP_FTP_DEDUP_MAX_CHUNK_SIZE) ?
+                store->chunk_size : (uint16_t)DANP_FTP_DEDUP_MAX_CHUNK_SIZE,
+            timeout_ms);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        DANP_FTP_LOG_INF("FTP dedup receive started");
+
+        while (!is_done)
+        {
+            status = danp_ftp_receive_message(handle, data_msg, timeout_ms);
+            if (status < 0)
+            {
+                DANP_FTP_LOG_ERR("FTP receive data failed");
+                break;
+            }
+
+            if (data_msg->header.type != DANP_FTP_PACKET_TYPE_DATA ||
+                data_msg->header.sequence_number != handle->sequence_number)
+            {
+                DANP_FTP_LOG_WRN(
+                    "FTP unexpected packet: type=%u seq=%u",
+                    data_msg->header.type,
+                    data_msg->header.sequence_number);
+
+                danp_ftp_send_message(
+                    handle,
+                    workspace,
+                    DANP_FTP_PACKET_TYPE_NACK,
+                    DANP_FTP_FLAG_NONE,
+                    NULL,
+                    0);
+                continue;
+            }
+
+            ack_length = 0;
+
+            if (data_msg->header.flags & DANP_FTP_FLAG_HASH_LIST)
+            {
+                count = data_msg->header.payload_length / DANP_FTP_SHA256_SIZE;
+                if (is_window_open || count > window ||
+                    (data_msg->header.payload_length % DANP_FTP_SHA256_SIZE) != 0)
+                {
+                    DANP_FTP_LOG_ERR("FTP dedup invalid hash list");
+                    status = DANP_FTP_STATUS_TRANSFER_FAILED;
+                    break;
+                }
+
+                /* Reuse what the store holds and reserve entries for the rest */
+                bitmap_len = (count + 7U) / 8U;
+                memset(ack_payload, 0, bitmap_len);
+                missing_left = 0;
+
+                for (i = 0; i < count; i++)
+                {
+                    const uint8_t *hash = &data_msg->payload[i * DANP_FTP_SHA256_SIZE];
+
+                    status = danp_ftp_chunk_store_find(store, hash);
+                    if (status >= 0)
+                    {
+                        slot_index[i] = (uint16_t)status;
+                        continue;
+                    }
+
+                    status = danp_ftp_chunk_store_reserve(store, hash);
+                    if (status < 0)
+                    {
+                        break;
+                    }
+                    slot_index[i] = (uint16_t)status;
+
+                    /* A chunk repeated within the window is requested once */
+                    for (j = 0; j < i; j++)
+                    {
+                        if (slot_index[j] == slot_index[i])
+                        {
+                            break;
+                        }
+                    }
+
+                    if (j == i)
+                    {
+                        ack_payload[i / 8U] |= (uint8_t)(1U << (i % 8U));
+                        missing_left++;
+                    }
+                }
+
+                if (status < 0)
+                {
+                    break;
+                }
+
+                memcpy(missing, ack_payload, bitmap_len);
+                ack_length = (uint16_t)bitmap_len;
+                is_window_open = true;
+                is_last = (data_msg->header.flags & DANP_FTP_FLAG_LAST_CHUNK) != 0;
+            }
+            else
+            {
+                slot = (data_msg->header.payload_length > 0) ? data_msg->payload[0] : count;
+                if (!is_window_open || slot >= count ||
+                    !(missing[slot / 8U] & (1U << (slot % 8U))))
+                {
+                    DANP_FTP_LOG_ERR("FTP dedup unexpected chunk");
+                    status = DANP_FTP_STATUS_TRANSFER_FAILED;
+                    break;
+                }
+
+                chunk_length = (uint16_t)(data_msg->header.payload_length - 1U);
+                danp_ftp_sha256(&data_msg->payload[1], chunk_length, digest);
+
+                if (memcmp(digest, store->entries[slot_index[slot]].hash, DANP_FTP_SHA256_SIZE) != 0)
+                {
+                    DANP_FTP_LOG_WRN("FTP dedup chunk %u hash mismatch", (unsigned)slot);
+
+                    danp_ftp_send_message(
+                        handle,
+                        workspace,
+                        DANP_FTP_PACKET_TYPE_NACK,
+                        DANP_FTP_FLAG_NONE,
+                        NULL,
+                        0);
+                    continue;
+                }
+
+                status = danp_ftp_chunk_store_fill(
+                    store,
+                    slot_index[slot],
+                    &data_msg->payload[1],
+                    chunk_length);
+
+                if (status < 0)
+                {
+                    DANP_FTP_LOG_ERR("FTP dedup chunk larger than the store slots");
+                    break;
+                }
+
+                missing[slot / 8U] &= (uint8_t)~(1U << (slot % 8U));
+                missing_left--;
+            }
+
+            /* Holding the ACK holds the sender, which is how a receiver yields the link */
+            danp_ftp_schedule_begin(handle, handle->sequence_number == 1);
+
+            /* A complete window goes to the sink in file order before it is acknowledged */
+            if (is_window_open && missing_left == 0)
+            {
+                for (i = 0; i < count; i++)
+                {
+                    chunk = danp_ftp_chunk_store_data(store, slot_index[i], &chunk_length);
+                    if (!chunk)
+                    {
+                        status = DANP_FTP_STATUS_ERROR;
+                        break;
+                    }
+
+                    sink_result = callback(
+                        handle,
+                        offset,
+                        chunk,
+                        chunk_length,
+                        (is_last && i + 1U == count) ? 0 : 1,
+                        user_data);
+
+                    if (sink_result < 0)
+                    {
+                        DANP_FTP_LOG_ERR(
+                            "FTP sink callback failed: %d",
+                            sink_result);
+                        status = sink_result;
+                        break;
+                    }
+
+                    offset += chunk_length;
+                }
+
+                /* An empty last window still tells the sink the file is complete */
+                if (status >= 0 && is_last && count == 0)
+                {
+                    sink_result = callback(handle, offset, data_msg->payload, 0, 0, user_data);
+                    if (sink_result < 0)
+                    {
+                        status = sink_result;
+                    }
+                }
+
+                handle->total_bytes_transferred = offset;
+                is_window_open = false;
+                is_done = is_last;
+            }
+
+            if (status >= 0)
+            {
+                status = danp_ftp_send_message(
+                    handle,
+                    workspace,
+                    DANP_FTP_PACKET_TYPE_ACK,
+                    DANP_FTP_FLAG_NONE,
+                    ack_payload,
+                    ack_length);
+            }
+
+            danp_ftp_schedule_end(handle);
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            handle->sequence_number++;
+        }
+
+        if (status < 0)
+        {
+            handle->state = DANP_FTP_STATE_ERROR;
+            break;
+        }
+
+        handle->state = DANP_FTP_STATE_COMPLETE;
+
+        DANP_FTP_LOG_INF(
+            "FTP dedup receive complete: %zu bytes",
+            handle->total_bytes_transferred);
+
+        danp_ftp_progress_report(handle, true);
+
+        status = (danp_ftp_status_t)handle->total_bytes_transferred;
+
+        break;
+    }
+
+    return status;
+}
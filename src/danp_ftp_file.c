@@ -0,0 +1,779 @@
+/* danp_ftp_file.c - ready-made file source and sink adapters for POSIX hosts */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE /* O_DIRECT */
+#endif
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "danp/ftp/danp_ftp_file.h"
+#include "danp_ftp_internal.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Opens a file for use as a transmit source.
+ * @param file Pointer to the file to open.
+ * @param path Path of the file to send.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_fd_open_source(
+    danp_ftp_fd_file_t *file,
+    const char *path)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    struct stat file_stat;
+
+    for (;;)
+    {
+        if (!file || !path)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(file, 0, sizeof(danp_ftp_fd_file_t));
+
+        file->fd = open(path, O_RDONLY);
+        if (file->fd < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot open %s", path);
+            status = DANP_FTP_STATUS_FILE_NOT_FOUND;
+            break;
+        }
+
+        if (fstat(file->fd, &file_stat) != 0)
+        {
+            close(file->fd);
+            file->fd = -1;
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        file->size = (size_t)file_stat.st_size;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Source callback reading chunks with pread().
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset of the chunk.
+ * @param data Buffer for the chunk.
+ * @param length Capacity of the buffer.
+ * @param more Set to 1 if more data remains.
+ * @param user_data Pointer to a danp_ftp_fd_file_t.
+ * @return Number of bytes read or negative status code.
+ */
+danp_ftp_status_t danp_ftp_fd_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data)
+{
+    danp_ftp_fd_file_t *file = (danp_ftp_fd_file_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    ssize_t read_result;
+
+    (void)handle;
+
+    for (;;)
+    {
+        if (!file || !data)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        read_result = pread(file->fd, data, length, (off_t)offset);
+        if (read_result < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP pread failed at offset %zu", offset);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (more)
+        {
+            /* Judged by size, a full read of the last chunk would otherwise promise more */
+            *more = offset + (size_t)read_result < file->size ? 1 : 0;
+        }
+
+        status = (danp_ftp_status_t)read_result;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Sink callback writing chunks with pwrite().
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset of the chunk.
+ * @param data Chunk data.
+ * @param length Length of the chunk.
+ * @param more Set to 1 if more data will follow.
+ * @param user_data Pointer to a danp_ftp_fd_file_t.
+ * @return Number of bytes written or negative status code.
+ */
+danp_ftp_status_t danp_ftp_fd_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data)
+{
+    danp_ftp_fd_file_t *file = (danp_ftp_fd_file_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    ssize_t write_result;
+
+    (void)handle;
+    (void)more;
+
+    for (;;)
+    {
+        if (!file || (!data && length > 0))
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        write_result = pwrite(file->fd, data, length, (off_t)offset);
+        if (write_result != (ssize_t)length)
+        {
+            DANP_FTP_LOG_ERR("FTP pwrite failed at offset %zu", offset);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        status = (danp_ftp_status_t)write_result;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Creates a file for block writes, bypassing the page cache where possible.
+ * @param file Pointer to the file to open.
+ * @param path Path of the file to create or truncate.
+ * @param direct Request O_DIRECT.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_fd_open_block_writer(
+    danp_ftp_fd_file_t *file,
+    const char *path,
+    bool direct)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!file || !path)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        file->fd = -1;
+        file->size = 0;
+        file->is_direct = false;
+        file->direct_writes = 0;
+        file->buffered_writes = 0;
+
+#if defined(O_DIRECT)
+        if (direct)
+        {
+            file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+            file->is_direct = file->fd >= 0;
+        }
+#else
+        (void)direct;
+#endif
+
+        if (file->fd < 0)
+        {
+            file->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        }
+
+        if (file->fd < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot create %s", path);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Block writer for the coalescing sink using pwrite().
+ * @param user_data Pointer to a danp_ftp_fd_file_t.
+ * @param offset File offset of the block.
+ * @param data Block data.
+ * @param length Block length.
+ * @return Number of bytes written or negative status code.
+ */
+danp_ftp_status_t danp_ftp_fd_block_write(
+    void *user_data,
+    size_t offset,
+    const uint8_t *data,
+    size_t length)
+{
+    danp_ftp_fd_file_t *file = (danp_ftp_fd_file_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t written = 0;
+    ssize_t write_result;
+    bool is_buffered = true;
+#if defined(O_DIRECT)
+    int fd_flags = -1;
+#endif
+
+    for (;;)
+    {
+        if (!file || file->fd < 0 || !data)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+#if defined(O_DIRECT)
+        is_buffered = !file->is_direct;
+
+        /* O_DIRECT needs aligned offsets, sizes and buffers; the tail block usually is not */
+        if (file->is_direct &&
+            ((offset % DANP_FTP_FILE_DIRECT_ALIGNMENT) != 0 ||
+             (length % DANP_FTP_FILE_DIRECT_ALIGNMENT) != 0 ||
+             ((uintptr_t)data % DANP_FTP_FILE_DIRECT_ALIGNMENT) != 0))
+        {
+            /* Only this write goes through the page cache, O_DIRECT is restored below */
+            fd_flags = fcntl(file->fd, F_GETFL);
+            if (fd_flags < 0 || fcntl(file->fd, F_SETFL, fd_flags & ~O_DIRECT) < 0)
+            {
+                DANP_FTP_LOG_ERR("FTP cannot clear O_DIRECT");
+                status = DANP_FTP_STATUS_ERROR;
+                break;
+            }
+            is_buffered = true;
+        }
+#endif
+
+        while (written < length)
+        {
+            write_result = pwrite(
+                file->fd,
+                data + written,
+                length - written,
+                (off_t)(offset + written));
+
+            if (write_result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (write_result <= 0)
+            {
+                DANP_FTP_LOG_ERR("FTP pwrite failed at offset %zu", offset + written);
+                status = DANP_FTP_STATUS_ERROR;
+                break;
+            }
+
+            written += (size_t)write_result;
+        }
+
+#if defined(O_DIRECT)
+        if (fd_flags >= 0 && fcntl(file->fd, F_SETFL, fd_flags) < 0)
+        {
+            /* Later blocks are still written, just no longer bypassing the page cache */
+            DANP_FTP_LOG_WRN("FTP cannot restore O_DIRECT");
+            file->is_direct = false;
+        }
+#endif
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (is_buffered)
+        {
+            file->buffered_writes++;
+        }
+        else
+        {
+            file->direct_writes++;
+        }
+
+        status = (danp_ftp_status_t)written;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Block sync for the coalescing sink using fdatasync().
+ * @param user_data Pointer to a danp_ftp_fd_file_t.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_fd_block_sync(void *user_data)
+{
+    danp_ftp_fd_file_t *file = (danp_ftp_fd_file_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!file || file->fd < 0)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (fdatasync(file->fd) != 0)
+        {
+            DANP_FTP_LOG_ERR("FTP fdatasync failed");
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Maps a file for use as a transmit source.
+ * @param source Pointer to the source to open.
+ * @param path Path of the file to send.
+ * @param readahead Readahead window in bytes, 0 for the default.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_mmap_source_open(
+    danp_ftp_mmap_source_t *source,
+    const char *path,
+    size_t readahead)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    struct stat file_stat;
+    void *mapping;
+
+    for (;;)
+    {
+        if (!source || !path)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(source, 0, sizeof(danp_ftp_mmap_source_t));
+        source->fd = -1;
+
+        source->fd = open(path, O_RDONLY);
+        if (source->fd < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot open %s", path);
+            status = DANP_FTP_STATUS_FILE_NOT_FOUND;
+            break;
+        }
+
+        if (fstat(source->fd, &file_stat) != 0)
+        {
+            close(source->fd);
+            source->fd = -1;
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        source->size = (size_t)file_stat.st_size;
+        source->readahead = readahead ? readahead : DANP_FTP_FILE_DEFAULT_READAHEAD;
+
+        /* Empty files cannot be mapped, the callback reports end of file instead */
+        if (source->size == 0)
+        {
+            break;
+        }
+
+        mapping = mmap(NULL, source->size, PROT_READ, MAP_PRIVATE, source->fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot map %s", path);
+            close(source->fd);
+            source->fd = -1;
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        source->data = (const uint8_t *)mapping;
+        posix_madvise(mapping, source->size, POSIX_MADV_SEQUENTIAL);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Source callback copying slices out of the mapping by offset.
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset of the chunk.
+ * @param data Buffer for the chunk.
+ * @param length Capacity of the buffer.
+ * @param more Set to 1 if more data remains.
+ * @param user_data Pointer to a danp_ftp_mmap_source_t.
+ * @return Number of bytes produced or negative status code.
+ */
+danp_ftp_status_t danp_ftp_mmap_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data)
+{
+    danp_ftp_mmap_source_t *source = (danp_ftp_mmap_source_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t available;
+    size_t advise_end;
+    size_t page_size;
+    size_t advise_start;
+
+    (void)handle;
+
+    for (;;)
+    {
+        if (!source || !data)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (offset >= source->size)
+        {
+            if (more)
+            {
+                *more = 0;
+            }
+            break;
+        }
+
+        available = source->size - offset;
+        if (available > length)
+        {
+            available = length;
+        }
+
+        /* Keep one readahead window in flight ahead of the reader */
+        if (source->advised_end < source->size &&
+            offset + available + (source->readahead / 2U) > source->advised_end)
+        {
+            page_size = (size_t)sysconf(_SC_PAGESIZE);
+            advise_start = (offset / page_size) * page_size;
+            advise_end = offset + source->readahead;
+            if (advise_end > source->size)
+            {
+                advise_end = source->size;
+            }
+
+            posix_madvise(
+                (void *)(uintptr_t)(source->data + advise_start),
+                advise_end - advise_start,
+                POSIX_MADV_WILLNEED);
+            source->advised_end = advise_end;
+        }
+
+        memcpy(data, source->data + offset, available);
+
+        if (more)
+        {
+            *more = offset + available < source->size ? 1 : 0;
+        }
+
+        status = (danp_ftp_status_t)available;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Unmaps and closes a mapped source.
+ * @param source Pointer to the source.
+ */
+void danp_ftp_mmap_source_close(danp_ftp_mmap_source_t *source)
+{
+    for (;;)
+    {
+        if (!source)
+        {
+            break;
+        }
+
+        if (source->data)
+        {
+            munmap((void *)(uintptr_t)source->data, source->size);
+            source->data = NULL;
+        }
+
+        if (source->fd >= 0)
+        {
+            close(source->fd);
+            source->fd = -1;
+        }
+
+        break;
+    }
+}
+
+/**
+ * @brief Resize the sink file and map it again.
+ * @param sink Pointer to the sink.
+ * @param capacity New capacity in bytes.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_mmap_sink_reserve(
+    danp_ftp_mmap_sink_t *sink,
+    size_t capacity)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    void *mapping;
+
+    for (;;)
+    {
+        if (sink->data)
+        {
+            munmap(sink->data, sink->capacity);
+            sink->data = NULL;
+            sink->capacity = 0;
+        }
+
+        /* Allocate blocks up front, fall back to a sparse extension */
+        if (posix_fallocate(sink->fd, 0, (off_t)capacity) != 0 &&
+            ftruncate(sink->fd, (off_t)capacity) != 0)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot allocate %zu bytes", capacity);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        mapping = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, sink->fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot map %zu bytes", capacity);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        posix_madvise(mapping, capacity, POSIX_MADV_SEQUENTIAL);
+
+        sink->data = (uint8_t *)mapping;
+        sink->capacity = capacity;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Creates a file and maps it as a receive sink.
+ * @param sink Pointer to the sink to open.
+ * @param path Path of the file to create or truncate.
+ * @param expected_size Expected file size in bytes.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_mmap_sink_open(
+    danp_ftp_mmap_sink_t *sink,
+    const char *path,
+    size_t expected_size)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!sink || !path)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(sink, 0, sizeof(danp_ftp_mmap_sink_t));
+
+        sink->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (sink->fd < 0)
+        {
+            DANP_FTP_LOG_ERR("FTP cannot create %s", path);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        if (expected_size > 0)
+        {
+            status = danp_ftp_mmap_sink_reserve(sink, expected_size);
+            if (status < 0)
+            {
+                close(sink->fd);
+                sink->fd = -1;
+                break;
+            }
+        }
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Sink callback copying chunks into the mapping at their offset.
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset of the chunk.
+ * @param data Chunk data.
+ * @param length Length of the chunk.
+ * @param more Set to 1 if more data will follow.
+ * @param user_data Pointer to a danp_ftp_mmap_sink_t.
+ * @return Number of bytes consumed or negative status code.
+ */
+danp_ftp_status_t danp_ftp_mmap_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data)
+{
+    danp_ftp_mmap_sink_t *sink = (danp_ftp_mmap_sink_t *)user_data;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t capacity;
+
+    (void)handle;
+    (void)more;
+
+    for (;;)
+    {
+        if (!sink || sink->fd < 0 || (!data && length > 0))
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (offset + length > sink->capacity)
+        {
+            capacity = sink->capacity ? sink->capacity : DANP_FTP_FILE_DEFAULT_READAHEAD;
+            while (capacity < offset + length)
+            {
+                capacity *= 2U;
+            }
+
+            status = danp_ftp_mmap_sink_reserve(sink, capacity);
+            if (status < 0)
+            {
+                break;
+            }
+        }
+
+        if (length > 0)
+        {
+            memcpy(sink->data + offset, data, length);
+        }
+
+        if (offset + length > sink->size)
+        {
+            sink->size = offset + length;
+        }
+
+        status = (danp_ftp_status_t)length;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Unmaps a sink, trims the file to the received size and closes it.
+ * @param sink Pointer to the sink.
+ * @param sync Flush the data to stable storage before closing.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_mmap_sink_close(
+    danp_ftp_mmap_sink_t *sink,
+    bool sync)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!sink || sink->fd < 0)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (sink->data)
+        {
+            if (sync && msync(sink->data, sink->capacity, MS_SYNC) != 0)
+            {
+                status = DANP_FTP_STATUS_ERROR;
+            }
+            munmap(sink->data, sink->capacity);
+            sink->data = NULL;
+        }
+
+        if (ftruncate(sink->fd, (off_t)sink->size) != 0)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+        }
+
+        if (sync && fsync(sink->fd) != 0)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+        }
+
+        close(sink->fd);
+        sink->fd = -1;
+
+        break;
+    }
+
+    return status;
+}
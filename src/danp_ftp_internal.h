@@ -0,0 +1,444 @@
+/* danp_ftp_internal.h - internal helpers shared between DANP FTP modules */
+
+/* All Rights Reserved */
+
+#ifndef INC_DANP_FTP_INTERNAL_H
+#define INC_DANP_FTP_INTERNAL_H
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp.h"
+#include "danp/danp.h"
+#include "danp_debug.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* Configurations */
+
+#ifndef CONFIG_DANP_FTP_LOG_LEVEL
+#define CONFIG_DANP_FTP_LOG_LEVEL             (2)
+#endif
+
+#ifndef CONFIG_DANP_FTP_CANCEL_POLL_MS
+#define CONFIG_DANP_FTP_CANCEL_POLL_MS        (100)
+#endif
+
+/* Definitions */
+
+#define DANP_FTP_PORT                         (CONFIG_DANP_FTP_SERVICE_PORT)
+#define DANP_FTP_CANCEL_POLL_MS               (CONFIG_DANP_FTP_CANCEL_POLL_MS)
+#define DANP_FTP_MAX_PAYLOAD_SIZE             (DANP_FTP_MAX_CHUNK_SIZE)
+#define DANP_FTP_DEFAULT_CHUNK_SIZE           (64)
+#define DANP_FTP_DEFAULT_TIMEOUT_MS           (5000)
+#define DANP_FTP_DEFAULT_MAX_RETRIES          (3)
+
+/* Read and write requests: [cmd][file_id_len][file_id][options] */
+#define DANP_FTP_MAX_REQUEST_FILE_ID_LEN      (DANP_FTP_MAX_PAYLOAD_SIZE - 3)
+
+#define DANP_FTP_CMD_REQUEST_READ             (0x01)
+#define DANP_FTP_CMD_REQUEST_WRITE            (0x02)
+#define DANP_FTP_CMD_ABORT                    (0x03)
+#define DANP_FTP_CMD_REQUEST_READ_BATCH       (0x04)
+#define DANP_FTP_CMD_LIST                     (0x05)
+#define DANP_FTP_CMD_PING                     (0x06)
+#define DANP_FTP_CMD_REQUEST_WRITE_MULTICAST  (0x07)
+#define DANP_FTP_CMD_MULTICAST_STATUS         (0x08)
+#define DANP_FTP_CMD_REQUEST_WRITE_DEDUP      (0x09)
+#define DANP_FTP_CMD_REQUEST_READ_DEDUP       (0x0A)
+
+#define DANP_FTP_RESP_OK                      (0x00)
+#define DANP_FTP_RESP_ERROR                   (0x01)
+#define DANP_FTP_RESP_FILE_NOT_FOUND          (0x02)
+#define DANP_FTP_RESP_BUSY                    (0x03)
+
+#define DANP_FTP_FLAG_NONE                    (0x00)
+#define DANP_FTP_FLAG_LAST_CHUNK              (0x01)
+#define DANP_FTP_FLAG_FIRST_CHUNK             (0x02)
+#define DANP_FTP_FLAG_LAST_FILE               (0x04)
+#define DANP_FTP_FLAG_FILE_MISSING            (0x08)
+#define DANP_FTP_FLAG_HASH_LIST               (0x10)
+#define DANP_FTP_FLAG_DIGEST                  (0x20)
+#define DANP_FTP_FLAG_HOLE                    (0x40)
+
+/* Options byte that may follow the file id of a read or write request */
+#define DANP_FTP_OPT_NONE                     (0x00)
+#define DANP_FTP_OPT_DIGEST                   (0x01)
+#define DANP_FTP_OPT_HOLES                    (0x02)
+
+/* Hole record payload: [length u32][value u8] */
+#define DANP_FTP_HOLE_RECORD_SIZE             (5)
+
+#define DANP_FTP_MANIFEST_ENTRY_FIXED_SIZE    (1 + 4 + 4 + 4)
+
+/* Log calls below the configured level are removed at compile time, arguments included */
+#if CONFIG_DANP_FTP_LOG_LEVEL >= 1
+#define DANP_FTP_LOG_ERR(...)                 danp_log_message(DANP_LOG_LEVEL_ERR, __VA_ARGS__)
+#else
+#define DANP_FTP_LOG_ERR(...)                 ((void)0)
+#endif
+
+#if CONFIG_DANP_FTP_LOG_LEVEL >= 2
+#define DANP_FTP_LOG_WRN(...)                 danp_log_message(DANP_LOG_LEVEL_WRN, __VA_ARGS__)
+#else
+#define DANP_FTP_LOG_WRN(...)                 ((void)0)
+#endif
+
+#if CONFIG_DANP_FTP_LOG_LEVEL >= 3
+#define DANP_FTP_LOG_INF(...)                 danp_log_message(DANP_LOG_LEVEL_INF, __VA_ARGS__)
+#else
+#define DANP_FTP_LOG_INF(...)                 ((void)0)
+#endif
+
+#if CONFIG_DANP_FTP_LOG_LEVEL >= 4
+#define DANP_FTP_LOG_DBG(...)                 danp_log_message(DANP_LOG_LEVEL_DBG, __VA_ARGS__)
+#else
+#define DANP_FTP_LOG_DBG(...)                 ((void)0)
+#endif
+
+#if defined(CONFIG_DANP_FTP_TRACE)
+#define DANP_FTP_TRACE(direction, handle, header) \
+    danp_ftp_trace_record( \
+        (direction), \
+        (handle), \
+        (header).type, \
+        (header).flags, \
+        (header).sequence_number, \
+        (header).payload_length)
+#else
+#define DANP_FTP_TRACE(direction, handle, header) ((void)0)
+#endif
+
+/* Stack workspace for transfers on handles without one, unless the static profile forbids it */
+#if defined(CONFIG_DANP_FTP_STATIC_WORKSPACE)
+#define DANP_FTP_WORKSPACE_FALLBACK(name)     danp_ftp_workspace_t *const name = NULL
+#else
+#define DANP_FTP_WORKSPACE_FALLBACK(name)     danp_ftp_workspace_t name##_storage; \
+                                              danp_ftp_workspace_t *const name = &name##_storage
+#endif
+
+#define DANP_FTP_TX_MESSAGE(workspace)        ((danp_ftp_message_t *)(void *)(workspace)->tx_packet)
+#define DANP_FTP_RX_MESSAGE(workspace)        ((danp_ftp_message_t *)(void *)(workspace)->rx_packet)
+
+/* Types */
+
+typedef struct danp_ftp_message_s
+{
+    danp_ftp_header_t header;
+    uint8_t payload[DANP_FTP_MAX_PAYLOAD_SIZE];
+} PACKED danp_ftp_message_t;
+
+/* External Declarations */
+
+/**
+ * @brief Reads a little-endian 32-bit value from a byte buffer.
+ *
+ * @param[in] data Pointer to the first byte.
+ *
+ * @return Decoded value.
+ */
+extern uint32_t danp_ftp_read_u32_le(
+    const uint8_t *data                            /* Source buffer */
+);
+
+/**
+ * @brief Reads a little-endian 16-bit value from a byte buffer.
+ *
+ * @param[in] data Pointer to the first byte.
+ *
+ * @return Decoded value.
+ */
+extern uint16_t danp_ftp_read_u16_le(
+    const uint8_t *data                            /* Source buffer */
+);
+
+/**
+ * @brief Writes a 32-bit value to a byte buffer in little-endian order.
+ *
+ * @param[out] data   Pointer to the first byte.
+ * @param[in]  value  Value to encode.
+ */
+extern void danp_ftp_write_u32_le(
+    uint8_t *data,                                 /* Destination buffer */
+    uint32_t value                                 /* Value */
+);
+
+/**
+ * @brief Writes a 16-bit value to a byte buffer in little-endian order.
+ *
+ * @param[out] data   Pointer to the first byte.
+ * @param[in]  value  Value to encode.
+ */
+extern void danp_ftp_write_u16_le(
+    uint8_t *data,                                 /* Destination buffer */
+    uint16_t value                                 /* Value */
+);
+
+/**
+ * @brief Sends an FTP protocol message stamped with the handle's sequence number.
+ *
+ * The message is built in the outgoing packet of `workspace`; a payload already in place there
+ * is sent without a copy.
+ *
+ * @param[in] handle          Pointer to the FTP handle.
+ * @param[in] workspace       Workspace of the transfer.
+ * @param[in] type            Packet type.
+ * @param[in] flags           Packet flags.
+ * @param[in] payload         Pointer to the payload data, may be NULL if `payload_length` is 0.
+ * @param[in] payload_length  Length of the payload.
+ *
+ * @return Status code.
+ */
+extern danp_ftp_status_t danp_ftp_send_message(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *workspace,               /* Transfer workspace */
+    danp_ftp_packet_type_t type,                   /* Packet type */
+    uint8_t flags,                                 /* Packet flags */
+    const uint8_t *payload,                        /* Payload */
+    uint16_t payload_length                        /* Payload length */
+);
+
+/**
+ * @brief Receives an FTP protocol message and verifies its CRC.
+ *
+ * An ABORT command from the remote side marks the handle cancelled, so every transfer loop stops
+ * on it without answering.
+ *
+ * @param[in]  handle      Pointer to the FTP handle.
+ * @param[out] message     Pointer to store the received message.
+ * @param[in]  timeout_ms  Timeout in milliseconds.
+ *
+ * @return Payload length on success, negative status code otherwise.
+ */
+extern danp_ftp_status_t danp_ftp_receive_message(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_message_t *message,                   /* Received message */
+    uint32_t timeout_ms                            /* Timeout in milliseconds */
+);
+
+/**
+ * @brief Waits for an ACK carrying the expected sequence number.
+ *
+ * @param[in] handle        Pointer to the FTP handle.
+ * @param[in] workspace     Workspace of the transfer, the ACK lands in its incoming packet.
+ * @param[in] expected_seq  Expected sequence number.
+ * @param[in] timeout_ms    Timeout in milliseconds.
+ *
+ * @return Status code.
+ */
+extern danp_ftp_status_t danp_ftp_wait_for_ack(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *workspace,               /* Transfer workspace */
+    uint16_t expected_seq,                         /* Expected sequence number */
+    uint32_t timeout_ms                            /* Timeout in milliseconds */
+);
+
+/**
+ * @brief Sends a DATA message until it is acknowledged.
+ *
+ * Does not advance the sequence number, the caller does once the exchange is done.
+ *
+ * @param[in] handle          Pointer to the FTP handle.
+ * @param[in] workspace       Workspace of the transfer.
+ * @param[in] flags           Packet flags.
+ * @param[in] payload         Pointer to the payload data, may be NULL if `payload_length` is 0.
+ * @param[in] payload_length  Length of the payload.
+ * @param[in] timeout_ms      Timeout in milliseconds for each ACK.
+ * @param[in] max_retries     Maximum number of attempts.
+ *
+ * @return Status code.
+ */
+extern danp_ftp_status_t danp_ftp_send_data_reliable(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *workspace,               /* Transfer workspace */
+    uint8_t flags,                                 /* Packet flags */
+    const uint8_t *payload,                        /* Payload */
+    uint16_t payload_length,                       /* Payload length */
+    uint32_t timeout_ms,                           /* Timeout in milliseconds */
+    uint8_t max_retries                            /* Maximum number of attempts */
+);
+
+/**
+ * @brief Sends a command message and waits for its response.
+ *
+ * Resets the handle's sequence number, as every command starts a new exchange.
+ *
+ * @param[in]  handle           Pointer to the FTP handle.
+ * @param[in]  workspace        Workspace of the transfer.
+ * @param[in]  command_payload  Pointer to the command payload.
+ * @param[in]  command_len      Length of the command payload.
+ * @param[in]  timeout_ms       Timeout in milliseconds.
+ * @param[out] response_code    Pointer to store the response code.
+ *
+ * @return Status code.
+ */
+extern danp_ftp_status_t danp_ftp_exchange_command(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *workspace,               /* Transfer workspace */
+    const uint8_t *command_payload,                /* Command payload */
+    size_t command_len,                            /* Command payload length */
+    uint32_t timeout_ms,                           /* Timeout in milliseconds */
+    uint8_t *response_code                         /* Response code */
+);
+
+/**
+ * @brief Creates a stream socket and connects it to the FTP service of a node.
+ *
+ * @param[in]  dst_node  Destination node ID.
+ * @param[out] socket    Pointer to store the connected socket.
+ *
+ * @return Status code indicating the result of the connection.
+ */
+extern danp_ftp_status_t danp_ftp_connect_socket(
+    uint16_t dst_node,                             /* Destination node ID */
+    danp_socket_t **socket                         /* Connected socket */
+);
+
+/**
+ * @brief Initializes an FTP handle around an already connected socket.
+ *
+ * @param[out] handle    Pointer to the FTP handle to initialize.
+ * @param[in]  socket    Connected socket.
+ * @param[in]  dst_node  Destination node ID.
+ */
+extern void danp_ftp_attach_socket(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_socket_t *socket,                         /* Connected socket */
+    uint16_t dst_node                              /* Destination node ID */
+);
+
+/**
+ * @brief Tells whether danp_ftp_cancel() was called for the transfer running on a handle.
+ *
+ * @param[in] handle Pointer to the FTP handle.
+ *
+ * @return true if the transfer must stop.
+ */
+extern bool danp_ftp_is_cancelled(
+    const danp_ftp_handle_t *handle                /* FTP handle */
+);
+
+/**
+ * @brief Invokes the progress callback of a handle if its interval has elapsed.
+ *
+ * @param[in] handle    Pointer to the FTP handle.
+ * @param[in] is_final  Report regardless of the interval, used when a transfer completes.
+ */
+extern void danp_ftp_progress_report(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    bool is_final                                  /* Final report */
+);
+
+/**
+ * @brief Paces a data packet through the handle and global rate limiters.
+ *
+ * The wait is cut in CONFIG_DANP_FTP_CANCEL_POLL_MS slices so that a cancel stops it.
+ *
+ * @param[in] handle  Pointer to the FTP handle.
+ * @param[in] bytes   Size of the packet on the wire.
+ *
+ * @return Status code, DANP_FTP_STATUS_CANCELLED if the transfer was cancelled meanwhile.
+ */
+extern danp_ftp_status_t danp_ftp_rate_limit_packet(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    size_t bytes                                   /* Packet size */
+);
+
+/**
+ * @brief Waits for the scheduler of a handle before a chunk exchange.
+ *
+ * Does nothing if the handle has no scheduler. Must be paired with danp_ftp_schedule_end(). A
+ * transfer cancelled while it queues leaves the queue without the link; its next packet then
+ * fails with DANP_FTP_STATUS_CANCELLED.
+ *
+ * @param[in] handle    Pointer to the FTP handle.
+ * @param[in] is_first  True for the first chunk of a transfer.
+ */
+extern void danp_ftp_schedule_begin(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    bool is_first                                  /* First chunk of a transfer */
+);
+
+/**
+ * @brief Returns the link to the scheduler of a handle after a chunk exchange.
+ *
+ * @param[in] handle Pointer to the FTP handle.
+ */
+extern void danp_ftp_schedule_end(
+    danp_ftp_handle_t *handle                      /* FTP handle */
+);
+
+/**
+ * @brief Wakes a transfer of a handle queued in its scheduler so it sees the cancel.
+ *
+ * @param[in] handle Pointer to the FTP handle.
+ */
+extern void danp_ftp_schedule_wake(
+    danp_ftp_handle_t *handle                      /* FTP handle */
+);
+
+/**
+ * @brief Claims a workspace from the static pool.
+ *
+ * @return Pointer to the workspace, NULL if the pool is exhausted or
+ *         CONFIG_DANP_FTP_STATIC_WORKSPACE is not set.
+ */
+extern danp_ftp_workspace_t *danp_ftp_workspace_claim(void);
+
+/**
+ * @brief Detaches the workspace of a handle, returning it to the static pool if it came from it.
+ *
+ * @param[in] handle Pointer to the FTP handle.
+ */
+extern void danp_ftp_workspace_release(
+    danp_ftp_handle_t *handle                      /* FTP handle */
+);
+
+/**
+ * @brief Selects the workspace of a transfer.
+ *
+ * Returns the workspace attached to the handle, or `fallback` if there is none. The handle is
+ * not modified: a fallback on the caller's stack is passed down explicitly and never stored in
+ * the long-lived handle, which other threads may inspect or cancel.
+ *
+ * @param[in] handle    Pointer to the FTP handle.
+ * @param[in] fallback  Workspace to use if none is attached, may be NULL.
+ *
+ * @return The workspace, or NULL if the handle has none and there is no fallback.
+ */
+extern danp_ftp_workspace_t *danp_ftp_workspace_select(
+    danp_ftp_handle_t *handle,                     /* FTP handle */
+    danp_ftp_workspace_t *fallback                 /* Fallback workspace */
+);
+
+#if defined(CONFIG_DANP_FTP_TRACE)
+/**
+ * @brief Appends a packet event to the trace ring buffer.
+ *
+ * Lock-free and safe to call from several threads at once.
+ *
+ * @param[in] direction        DANP_FTP_TRACE_DIRECTION_TX or DANP_FTP_TRACE_DIRECTION_RX.
+ * @param[in] handle           Pointer to the FTP handle.
+ * @param[in] type             Packet type.
+ * @param[in] flags            Packet flags.
+ * @param[in] sequence_number  Packet sequence number.
+ * @param[in] payload_length   Packet payload length.
+ */
+extern void danp_ftp_trace_record(
+    uint8_t direction,                             /* Packet direction */
+    const danp_ftp_handle_t *handle,               /* FTP handle */
+    uint8_t type,                                  /* Packet type */
+    uint8_t flags,                                 /* Packet flags */
+    uint16_t sequence_number,                      /* Packet sequence number */
+    uint16_t payload_length                        /* Packet payload length */
+);
+#endif /* CONFIG_DANP_FTP_TRACE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DANP_FTP_INTERNAL_H */
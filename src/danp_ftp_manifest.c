@@ -0,0 +1,175 @@
+/* danp_ftp_manifest.c - client side cache of remote file manifests */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_manifest.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Initializes a manifest cache over caller-owned storage.
+ * @param manifest Pointer to the manifest cache to initialize.
+ * @param entries Storage for cached entries.
+ * @param capacity Number of entries in storage.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_manifest_init(
+    danp_ftp_manifest_t *manifest,
+    danp_ftp_manifest_entry_t *entries,
+    size_t capacity)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!manifest || !entries || capacity == 0)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        manifest->entries = entries;
+        manifest->capacity = capacity;
+        manifest->count = 0;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Looks up a cached entry by file ID.
+ * @param manifest Pointer to the manifest cache.
+ * @param file_id File name/id.
+ * @param file_id_len File name/id len.
+ * @return Pointer to the cached entry or NULL.
+ */
+danp_ftp_manifest_entry_t *danp_ftp_manifest_find(
+    const danp_ftp_manifest_t *manifest,
+    const uint8_t *file_id,
+    size_t file_id_len)
+{
+    danp_ftp_manifest_entry_t *found = NULL;
+    size_t i;
+
+    for (;;)
+    {
+        if (!manifest || !file_id)
+        {
+            break;
+        }
+
+        for (i = 0; i < manifest->count; i++)
+        {
+            danp_ftp_manifest_entry_t *entry = &manifest->entries[i];
+
+            if (entry->file_id_len == file_id_len &&
+                memcmp(entry->file_id, file_id, file_id_len) == 0)
+            {
+                found = entry;
+                break;
+            }
+        }
+
+        break;
+    }
+
+    return found;
+}
+
+/**
+ * @brief Checks whether a remote entry is new or differs from the cached one.
+ * @param manifest Pointer to the manifest cache.
+ * @param entry Remote manifest entry.
+ * @return true if the file needs to be fetched.
+ */
+bool danp_ftp_manifest_is_changed(
+    const danp_ftp_manifest_t *manifest,
+    const danp_ftp_manifest_entry_t *entry)
+{
+    const danp_ftp_manifest_entry_t *cached;
+    bool changed = true;
+
+    for (;;)
+    {
+        if (!manifest || !entry)
+        {
+            break;
+        }
+
+        cached = danp_ftp_manifest_find(manifest, entry->file_id, entry->file_id_len);
+        if (!cached)
+        {
+            break;
+        }
+
+        changed = cached->size != entry->size ||
+            cached->mtime != entry->mtime ||
+            cached->checksum != entry->checksum;
+
+        break;
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Inserts or replaces a cached entry.
+ * @param manifest Pointer to the manifest cache.
+ * @param entry Entry to store.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_manifest_update(
+    danp_ftp_manifest_t *manifest,
+    const danp_ftp_manifest_entry_t *entry)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_manifest_entry_t *cached;
+
+    for (;;)
+    {
+        if (!manifest || !entry || entry->file_id_len > DANP_FTP_MAX_FILE_ID_LEN)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        cached = danp_ftp_manifest_find(manifest, entry->file_id, entry->file_id_len);
+        if (!cached)
+        {
+            if (manifest->count >= manifest->capacity)
+            {
+                status = DANP_FTP_STATUS_ERROR;
+                break;
+            }
+
+            cached = &manifest->entries[manifest->count];
+            manifest->count++;
+        }
+
+        memcpy(cached, entry, sizeof(danp_ftp_manifest_entry_t));
+
+        break;
+    }
+
+    return status;
+}
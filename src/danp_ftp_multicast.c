@@ -0,0 +1,544 @@
+/* danp_ftp_multicast.c - one-to-many file distribution with NACK based repair */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_multicast.h"
+#include "danp/danp.h"
+#include "danp_ftp_internal.h"
+#include <stdbool.h>
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_FTP_MULTICAST_WINDOW_CHUNKS      ((DANP_FTP_MAX_PAYLOAD_SIZE - 1U) * 8U)
+#define DANP_FTP_MULTICAST_MAX_FILE_ID_LEN    (DANP_FTP_MAX_PAYLOAD_SIZE - 8)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Check whether any bit is set in a bitmap.
+ * @param bitmap Pointer to the bitmap.
+ * @param size Size of the bitmap in bytes.
+ * @return true if at least one bit is set.
+ */
+static bool danp_ftp_multicast_bitmap_any(const uint8_t *bitmap, size_t size)
+{
+    bool any = false;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        if (bitmap[i] != 0)
+        {
+            any = true;
+            break;
+        }
+    }
+
+    return any;
+}
+
+/**
+ * @brief Ask a receiver to accept the multicast file.
+ * @param member Pointer to the receiver handle.
+ * @param workspace Workspace used with the receiver.
+ * @param config Pointer to the multicast configuration.
+ * @param timeout_ms Timeout in milliseconds.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_multicast_open(
+    danp_ftp_handle_t *member,
+    danp_ftp_workspace_t *workspace,
+    const danp_ftp_multicast_config_t *config,
+    uint32_t timeout_ms)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint8_t *command_payload = DANP_FTP_TX_MESSAGE(workspace)->payload;
+    size_t command_len;
+    uint8_t response_code = DANP_FTP_RESP_ERROR;
+
+    for (;;)
+    {
+        if (!member->is_initialized)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Build command payload: [cmd][file_id_len][file_id][file_size][chunk_size] */
+        command_payload[0] = DANP_FTP_CMD_REQUEST_WRITE_MULTICAST;
+        command_payload[1] = (uint8_t)config->file_id_len;
+        memcpy(&command_payload[2], config->file_id, config->file_id_len);
+        command_len = 2 + config->file_id_len;
+        danp_ftp_write_u32_le(&command_payload[command_len], (uint32_t)config->file_size);
+        danp_ftp_write_u16_le(&command_payload[command_len + 4], config->chunk_size);
+        command_len += 6;
+
+        status = danp_ftp_exchange_command(
+            member,
+            workspace,
+            command_payload,
+            command_len,
+            timeout_ms,
+            &response_code);
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response_code != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_WRN(
+                "FTP multicast rejected by node %u: %u",
+                member->dst_node,
+                response_code);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Send one data chunk to every active receiver of the group.
+ * @param group Pointer to the receiver group.
+ * @param fallback Workspace shared by the handles without one, may be NULL.
+ * @param chunk_index Index of the chunk, carried in the sequence number.
+ * @param flags Packet flags.
+ * @param data Pointer to the chunk data.
+ * @param length Length of the chunk.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_multicast_send_chunk(
+    danp_ftp_multicast_group_t *group,
+    danp_ftp_workspace_t *fallback,
+    uint16_t chunk_index,
+    uint8_t flags,
+    const uint8_t *data,
+    uint16_t length)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    size_t i;
+
+    for (;;)
+    {
+        if (group->channel)
+        {
+            group->channel->sequence_number = chunk_index;
+            status = danp_ftp_send_message(
+                group->channel,
+                danp_ftp_workspace_select(group->channel, fallback),
+                DANP_FTP_PACKET_TYPE_DATA,
+                flags,
+                data,
+                length);
+            break;
+        }
+
+        for (i = 0; i < group->member_count; i++)
+        {
+            danp_ftp_handle_t *member = &group->members[i];
+
+            if (member->state != DANP_FTP_STATE_TRANSFERRING)
+            {
+                continue;
+            }
+
+            member->sequence_number = chunk_index;
+            if (danp_ftp_send_message(
+                    member,
+                    danp_ftp_workspace_select(member, fallback),
+                    DANP_FTP_PACKET_TYPE_DATA,
+                    flags,
+                    data,
+                    length) < 0)
+            {
+                /* Loss is repaired from the status report */
+                DANP_FTP_LOG_WRN(
+                    "FTP multicast send to node %u failed",
+                    member->dst_node);
+            }
+        }
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Collect the missing chunk report of one receiver.
+ * @param member Pointer to the receiver handle.
+ * @param workspace Workspace used with the receiver.
+ * @param chunk_count Number of chunks in the file.
+ * @param bitmap Union bitmap to merge the report into.
+ * @param timeout_ms Timeout in milliseconds.
+ * @param missing Set to true if the receiver misses any chunk.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_multicast_collect(
+    danp_ftp_handle_t *member,
+    danp_ftp_workspace_t *workspace,
+    size_t chunk_count,
+    uint8_t *bitmap,
+    uint32_t timeout_ms,
+    bool *missing)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_message_t *response = DANP_FTP_RX_MESSAGE(workspace);
+    uint8_t command_payload[3];
+    size_t start;
+    size_t bit;
+
+    *missing = false;
+
+    for (start = 0; start < chunk_count; start += DANP_FTP_MULTICAST_WINDOW_CHUNKS)
+    {
+        /* Build command payload: [cmd][first_chunk] */
+        command_payload[0] = DANP_FTP_CMD_MULTICAST_STATUS;
+        danp_ftp_write_u16_le(&command_payload[1], (uint16_t)start);
+
+        member->sequence_number = 0;
+        status = danp_ftp_send_message(
+            member,
+            workspace,
+            DANP_FTP_PACKET_TYPE_COMMAND,
+            DANP_FTP_FLAG_NONE,
+            command_payload,
+            sizeof(command_payload));
+
+        if (status < 0)
+        {
+            break;
+        }
+
+        status = danp_ftp_receive_message(member, response, timeout_ms);
+        if (status < 0)
+        {
+            break;
+        }
+
+        if (response->header.type != DANP_FTP_PACKET_TYPE_RESPONSE ||
+            response->payload[0] != DANP_FTP_RESP_OK)
+        {
+            DANP_FTP_LOG_WRN(
+                "FTP multicast status rejected by node %u",
+                member->dst_node);
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        status = DANP_FTP_STATUS_OK;
+
+        /* Response layout: [code][bitmap of missing chunks from first_chunk], empty if none */
+        if (response->header.payload_length <= 1)
+        {
+            break;
+        }
+
+        for (bit = 0; bit < (size_t)(response->header.payload_length - 1U) * 8U; bit++)
+        {
+            size_t chunk_index = start + bit;
+
+            if (chunk_index >= chunk_count)
+            {
+                break;
+            }
+
+            if (response->payload[1 + (bit / 8)] & (1U << (bit % 8)))
+            {
+                bitmap[chunk_index / 8] |= (uint8_t)(1U << (chunk_index % 8));
+                *missing = true;
+            }
+        }
+    }
+
+    return status;
+}
+
+/**
+ * @brief Distributes one file to a group of receivers.
+ * @param group Pointer to the receiver group.
+ * @param config Pointer to the multicast configuration structure.
+ * @param callback Source callback function to provide data.
+ * @param user_data User-defined data passed to the callback.
+ * @return Number of receivers holding the complete file or negative status code.
+ */
+danp_ftp_status_t danp_ftp_multicast_transmit(
+    danp_ftp_multicast_group_t *group,
+    const danp_ftp_multicast_config_t *config,
+    danp_ftp_source_cb_t callback,
+    void *user_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint8_t *chunk_buffer;
+    danp_ftp_handle_t *source_handle;
+    danp_ftp_workspace_t *source_workspace;
+    size_t chunk_count;
+    size_t bitmap_size;
+    size_t active = 0;
+    size_t chunk_index;
+    size_t i;
+    uint32_t timeout_ms;
+    uint8_t round;
+    uint8_t more;
+    uint8_t flags;
+    DANP_FTP_WORKSPACE_FALLBACK(fallback_workspace);
+
+    for (;;)
+    {
+        if (!group || !group->members || group->member_count == 0 || !config || !callback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (!config->file_id || config->file_id_len == 0 ||
+            config->file_id_len > DANP_FTP_MULTICAST_MAX_FILE_ID_LEN)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid file ID");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        if (config->chunk_size == 0 || config->chunk_size > DANP_FTP_MAX_PAYLOAD_SIZE ||
+            config->file_size > UINT32_MAX)
+        {
+            DANP_FTP_LOG_ERR("FTP invalid multicast layout");
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        chunk_count = (config->file_size + config->chunk_size - 1U) / config->chunk_size;
+        bitmap_size = (chunk_count + 7U) / 8U;
+        if (chunk_count > DANP_FTP_MULTICAST_MAX_CHUNKS || !config->missing_bitmap ||
+            config->bitmap_size < bitmap_size)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP multicast bitmap too small for %zu chunks",
+                chunk_count);
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        timeout_ms = config->timeout_ms;
+        if (timeout_ms == 0)
+        {
+            timeout_ms = DANP_FTP_DEFAULT_TIMEOUT_MS;
+        }
+
+        /* Handles without a workspace share the fallback, the group is driven sequentially */
+        if (group->channel && !danp_ftp_workspace_select(group->channel, fallback_workspace))
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Open the transfer on every receiver */
+        for (i = 0; i < group->member_count; i++)
+        {
+            danp_ftp_handle_t *member = &group->members[i];
+
+            danp_ftp_workspace_t *workspace = danp_ftp_workspace_select(member, fallback_workspace);
+
+            if (!workspace || danp_ftp_multicast_open(member, workspace, config, timeout_ms) < 0)
+            {
+                member->state = DANP_FTP_STATE_ERROR;
+                continue;
+            }
+
+            member->state = DANP_FTP_STATE_TRANSFERRING;
+            member->total_bytes_transferred = 0;
+            active++;
+        }
+
+        if (active == 0)
+        {
+            DANP_FTP_LOG_ERR("FTP multicast has no receivers");
+            status = DANP_FTP_STATUS_TRANSFER_FAILED;
+            break;
+        }
+
+        DANP_FTP_LOG_INF(
+            "FTP multicast started: %zu receivers, %zu chunks",
+            active,
+            chunk_count);
+
+        source_handle = group->channel ? group->channel : &group->members[0];
+        source_workspace = danp_ftp_workspace_select(source_handle, fallback_workspace);
+        if (!source_workspace)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        /* Chunks are read into the outgoing packet; receivers sharing it send without a copy */
+        chunk_buffer = DANP_FTP_TX_MESSAGE(source_workspace)->payload;
+
+        /* The first round sends every chunk */
+        memset(config->missing_bitmap, 0, bitmap_size);
+        for (chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+        {
+            config->missing_bitmap[chunk_index / 8] |= (uint8_t)(1U << (chunk_index % 8));
+        }
+
+        for (round = 0; round <= config->max_rounds; round++)
+        {
+            if (active == 0 || !danp_ftp_multicast_bitmap_any(config->missing_bitmap, bitmap_size))
+            {
+                break;
+            }
+
+            for (chunk_index = 0; chunk_index < chunk_count; chunk_index++)
+            {
+                size_t offset = chunk_index * config->chunk_size;
+                size_t expected = config->file_size - offset;
+                danp_ftp_status_t read_result;
+
+                if (!(config->missing_bitmap[chunk_index / 8] & (1U << (chunk_index % 8))))
+                {
+                    continue;
+                }
+
+                if (expected > config->chunk_size)
+                {
+                    expected = config->chunk_size;
+                }
+
+                more = 0;
+                read_result = callback(
+                    source_handle,
+                    offset,
+                    chunk_buffer,
+                    (uint16_t)expected,
+                    &more,
+                    user_data);
+
+                if (read_result != (danp_ftp_status_t)expected)
+                {
+                    DANP_FTP_LOG_ERR(
+                        "FTP multicast source failed at offset %zu: %d",
+                        offset,
+                        read_result);
+                    status = read_result < 0 ? read_result : DANP_FTP_STATUS_TRANSFER_FAILED;
+                    break;
+                }
+
+                flags = DANP_FTP_FLAG_NONE;
+                if (chunk_index == 0)
+                {
+                    flags |= DANP_FTP_FLAG_FIRST_CHUNK;
+                }
+                if (chunk_index == chunk_count - 1U)
+                {
+                    flags |= DANP_FTP_FLAG_LAST_CHUNK;
+                }
+
+                status = danp_ftp_multicast_send_chunk(
+                    group,
+                    fallback_workspace,
+                    (uint16_t)chunk_index,
+                    flags,
+                    chunk_buffer,
+                    (uint16_t)expected);
+
+                if (status < 0)
+                {
+                    break;
+                }
+            }
+
+            if (status < 0)
+            {
+                break;
+            }
+
+            /* Gather the union of chunks still missing on any receiver */
+            memset(config->missing_bitmap, 0, bitmap_size);
+            for (i = 0; i < group->member_count; i++)
+            {
+                danp_ftp_handle_t *member = &group->members[i];
+                bool missing = false;
+
+                if (member->state != DANP_FTP_STATE_TRANSFERRING)
+                {
+                    continue;
+                }
+
+                if (danp_ftp_multicast_collect(
+                        member,
+                        danp_ftp_workspace_select(member, fallback_workspace),
+                        chunk_count,
+                        config->missing_bitmap,
+                        timeout_ms,
+                        &missing) < 0 ||
+                    (missing && round == config->max_rounds))
+                {
+                    member->state = DANP_FTP_STATE_ERROR;
+                    active--;
+                }
+            }
+
+            DANP_FTP_LOG_INF(
+                "FTP multicast round %u done, %zu receivers active",
+                round,
+                active);
+        }
+
+        if (status < 0)
+        {
+            for (i = 0; i < group->member_count; i++)
+            {
+                group->members[i].state = DANP_FTP_STATE_ERROR;
+            }
+            break;
+        }
+
+        for (i = 0; i < group->member_count; i++)
+        {
+            danp_ftp_handle_t *member = &group->members[i];
+
+            if (member->state == DANP_FTP_STATE_TRANSFERRING)
+            {
+                member->state = DANP_FTP_STATE_COMPLETE;
+                member->total_bytes_transferred = config->file_size;
+            }
+
+            if (config->member_status)
+            {
+                config->member_status[i] = member->state == DANP_FTP_STATE_COMPLETE ?
+                    (danp_ftp_status_t)config->file_size :
+                    DANP_FTP_STATUS_TRANSFER_FAILED;
+            }
+        }
+
+        DANP_FTP_LOG_INF(
+            "FTP multicast complete: %zu/%zu receivers",
+            active,
+            group->member_count);
+
+        status = (danp_ftp_status_t)active;
+
+        break;
+    }
+
+    return status;
+}
@@ -0,0 +1,433 @@
+/* danp_ftp_pool.c - per-node pool of warm FTP connections */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_pool.h"
+#include "danp/danp.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_FTP_POOL_DEFAULT_IDLE_TIMEOUT_MS (30000)
+#define DANP_FTP_POOL_DEFAULT_HEALTH_CHECK_MS (5000)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Check whether a pooled connection has been idle for longer than a limit.
+ * @param entry Pointer to the pool entry.
+ * @param now_us Current time in microseconds.
+ * @param limit_ms Idle limit in milliseconds, 0 for no limit.
+ * @return true if the limit is exceeded.
+ */
+static bool danp_ftp_pool_idle_exceeds(
+    const danp_ftp_pool_entry_t *entry,
+    uint64_t now_us,
+    uint32_t limit_ms)
+{
+    return limit_ms != 0 && (now_us - entry->last_used_us) > ((uint64_t)limit_ms * 1000U);
+}
+
+/**
+ * @brief Close the connection of a pool entry and free the slot.
+ * @param entry Pointer to the pool entry.
+ */
+static void danp_ftp_pool_close_entry(danp_ftp_pool_entry_t *entry)
+{
+    if (entry->socket)
+    {
+        danp_close(entry->socket);
+    }
+
+    memset(entry, 0, sizeof(danp_ftp_pool_entry_t));
+}
+
+/**
+ * @brief Find a slot for a new connection, evicting the least recently used idle one if full.
+ * @param pool Pointer to the pool, locked.
+ * @return Pointer to the free slot, NULL if every connection is in use.
+ */
+static danp_ftp_pool_entry_t *danp_ftp_pool_claim_slot(danp_ftp_pool_t *pool)
+{
+    danp_ftp_pool_entry_t *oldest = NULL;
+    danp_ftp_pool_entry_t *slot = NULL;
+    size_t i;
+
+    for (i = 0; i < DANP_FTP_POOL_SIZE; i++)
+    {
+        danp_ftp_pool_entry_t *entry = &pool->entries[i];
+
+        if (!entry->socket)
+        {
+            slot = entry;
+            break;
+        }
+
+        if (!entry->in_use && (!oldest || entry->last_used_us < oldest->last_used_us))
+        {
+            oldest = entry;
+        }
+    }
+
+    /* More nodes than slots: the coldest connection makes room */
+    if (!slot && oldest)
+    {
+        danp_ftp_pool_close_entry(oldest);
+        pool->stats.evictions++;
+        slot = oldest;
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Initializes a connection pool.
+ * @param pool Pointer to the pool to initialize.
+ * @param config Pointer to the pool configuration, NULL for defaults.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_pool_init(
+    danp_ftp_pool_t *pool,
+    const danp_ftp_pool_config_t *config)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!pool)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(pool, 0, sizeof(danp_ftp_pool_t));
+
+        if (config)
+        {
+            pool->config = *config;
+        }
+        else
+        {
+            pool->config.idle_timeout_ms = DANP_FTP_POOL_DEFAULT_IDLE_TIMEOUT_MS;
+            pool->config.health_check_ms = DANP_FTP_POOL_DEFAULT_HEALTH_CHECK_MS;
+        }
+
+        danp_ftp_port_mutex_init(&pool->lock);
+        pool->is_initialized = true;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Closes all idle connections and deinitializes the pool.
+ * @param pool Pointer to the pool.
+ */
+void danp_ftp_pool_deinit(danp_ftp_pool_t *pool)
+{
+    size_t i;
+
+    for (;;)
+    {
+        if (!pool || !pool->is_initialized)
+        {
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        for (i = 0; i < DANP_FTP_POOL_SIZE; i++)
+        {
+            if (!pool->entries[i].in_use)
+            {
+                danp_ftp_pool_close_entry(&pool->entries[i]);
+            }
+        }
+
+        pool->is_initialized = false;
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+        danp_ftp_port_mutex_destroy(&pool->lock);
+
+        break;
+    }
+}
+
+/**
+ * @brief Initializes an FTP handle from the pool.
+ * @param pool Pointer to the pool.
+ * @param handle Pointer to the FTP handle to initialize.
+ * @param dst_node Destination node ID.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_pool_acquire(
+    danp_ftp_pool_t *pool,
+    danp_ftp_handle_t *handle,
+    uint16_t dst_node)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    danp_ftp_pool_entry_t *slot = NULL;
+    danp_socket_t *sock = NULL;
+    bool needs_check = false;
+    uint64_t start_us;
+    uint64_t elapsed_us;
+    size_t i;
+
+    for (;;)
+    {
+        if (!pool || !pool->is_initialized || !handle)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(handle, 0, sizeof(danp_ftp_handle_t));
+
+        /* Look for a warm connection to the node */
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        start_us = danp_ftp_port_time_us();
+        for (i = 0; i < DANP_FTP_POOL_SIZE; i++)
+        {
+            danp_ftp_pool_entry_t *entry = &pool->entries[i];
+
+            if (!entry->socket || entry->in_use || entry->dst_node != dst_node)
+            {
+                continue;
+            }
+
+            if (danp_ftp_pool_idle_exceeds(entry, start_us, pool->config.idle_timeout_ms))
+            {
+                danp_ftp_pool_close_entry(entry);
+                pool->stats.evictions++;
+                continue;
+            }
+
+            needs_check = danp_ftp_pool_idle_exceeds(
+                entry,
+                start_us,
+                pool->config.health_check_ms);
+            entry->in_use = true;
+            slot = entry;
+            break;
+        }
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+
+        if (slot)
+        {
+            danp_ftp_attach_socket(handle, slot->socket, dst_node);
+
+            if (needs_check && danp_ftp_ping(handle, pool->config.timeout_ms) < 0)
+            {
+                DANP_FTP_LOG_WRN(
+                    "FTP pooled connection to node %u failed health check",
+                    dst_node);
+
+                danp_ftp_port_mutex_lock(&pool->lock);
+                danp_ftp_pool_close_entry(slot);
+                pool->stats.health_check_failures++;
+                danp_ftp_port_mutex_unlock(&pool->lock);
+
+                danp_ftp_workspace_release(handle);
+                memset(handle, 0, sizeof(danp_ftp_handle_t));
+                slot = NULL;
+            }
+            else
+            {
+                danp_ftp_port_mutex_lock(&pool->lock);
+                pool->stats.reuses++;
+                danp_ftp_port_mutex_unlock(&pool->lock);
+                break;
+            }
+        }
+
+        /* No usable warm connection, open a new one */
+        start_us = danp_ftp_port_time_us();
+        status = danp_ftp_connect_socket(dst_node, &sock);
+        if (status < 0)
+        {
+            break;
+        }
+        elapsed_us = danp_ftp_port_time_us() - start_us;
+
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        pool->stats.connects++;
+        pool->stats.connect_time_us += elapsed_us;
+
+        slot = danp_ftp_pool_claim_slot(pool);
+        if (slot)
+        {
+            slot->socket = sock;
+            slot->dst_node = dst_node;
+            slot->in_use = true;
+        }
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+
+        danp_ftp_attach_socket(handle, sock, dst_node);
+
+        DANP_FTP_LOG_INF(
+            "FTP pool connected to node %u in %u us",
+            dst_node,
+            (unsigned int)elapsed_us);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Returns the connection of an FTP handle to the pool.
+ * @param pool Pointer to the pool.
+ * @param handle Pointer to the FTP handle.
+ */
+void danp_ftp_pool_release(
+    danp_ftp_pool_t *pool,
+    danp_ftp_handle_t *handle)
+{
+    danp_ftp_pool_entry_t *slot = NULL;
+    size_t i;
+
+    for (;;)
+    {
+        if (!pool || !pool->is_initialized || !handle || !handle->is_initialized)
+        {
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        for (i = 0; i < DANP_FTP_POOL_SIZE; i++)
+        {
+            if (pool->entries[i].in_use && pool->entries[i].socket == handle->socket)
+            {
+                slot = &pool->entries[i];
+                break;
+            }
+        }
+
+        if (slot)
+        {
+            if (handle->state == DANP_FTP_STATE_ERROR)
+            {
+                /* Connection state is unknown after a failed transfer */
+                danp_ftp_pool_close_entry(slot);
+            }
+            else
+            {
+                slot->in_use = false;
+                slot->last_used_us = danp_ftp_port_time_us();
+            }
+        }
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+
+        if (!slot)
+        {
+            /* Pool was full when the handle was acquired */
+            danp_ftp_deinit(handle);
+            break;
+        }
+
+        danp_ftp_workspace_release(handle);
+        handle->socket = NULL;
+        handle->is_initialized = false;
+        handle->state = DANP_FTP_STATE_IDLE;
+
+        break;
+    }
+}
+
+/**
+ * @brief Closes idle connections that exceeded the idle timeout.
+ * @param pool Pointer to the pool.
+ * @return Number of connections closed.
+ */
+size_t danp_ftp_pool_prune(danp_ftp_pool_t *pool)
+{
+    size_t closed = 0;
+    uint64_t now_us;
+    size_t i;
+
+    for (;;)
+    {
+        if (!pool || !pool->is_initialized)
+        {
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        now_us = danp_ftp_port_time_us();
+        for (i = 0; i < DANP_FTP_POOL_SIZE; i++)
+        {
+            danp_ftp_pool_entry_t *entry = &pool->entries[i];
+
+            if (entry->socket && !entry->in_use &&
+                danp_ftp_pool_idle_exceeds(entry, now_us, pool->config.idle_timeout_ms))
+            {
+                danp_ftp_pool_close_entry(entry);
+                pool->stats.evictions++;
+                closed++;
+            }
+        }
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+
+        break;
+    }
+
+    return closed;
+}
+
+/**
+ * @brief Reads the pool statistics.
+ * @param pool Pointer to the pool.
+ * @param stats Pointer to store the statistics.
+ */
+void danp_ftp_pool_get_stats(
+    danp_ftp_pool_t *pool,
+    danp_ftp_pool_stats_t *stats)
+{
+    for (;;)
+    {
+        if (!pool || !pool->is_initialized || !stats)
+        {
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&pool->lock);
+
+        *stats = pool->stats;
+        if (stats->connects > 0)
+        {
+            /* Each reuse saves one average connect */
+            stats->saved_time_us =
+                (stats->connect_time_us / stats->connects) * stats->reuses;
+        }
+
+        danp_ftp_port_mutex_unlock(&pool->lock);
+
+        break;
+    }
+}
@@ -0,0 +1,233 @@
+/* danp_ftp_port.c - operating system abstraction used by DANP FTP */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#if !defined(__ZEPHYR__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "danp/ftp/danp_ftp_port.h"
+
+#if !defined(__ZEPHYR__)
+#include <errno.h>
+#include <time.h>
+#endif
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+#if defined(__ZEPHYR__)
+
+/**
+ * @brief Returns a monotonic timestamp from the kernel uptime.
+ * @return Time in microseconds since an unspecified starting point.
+ */
+uint64_t danp_ftp_port_time_us(void)
+{
+    return k_ticks_to_us_floor64((uint64_t)k_uptime_ticks());
+}
+
+/**
+ * @brief Suspends the calling thread.
+ * @param duration_us Time to sleep in microseconds.
+ */
+void danp_ftp_port_sleep_us(uint32_t duration_us)
+{
+    k_usleep((int32_t)duration_us);
+}
+
+/**
+ * @brief Initializes a mutex.
+ * @param mutex Pointer to the mutex to initialize.
+ */
+void danp_ftp_port_mutex_init(danp_ftp_mutex_t *mutex)
+{
+    k_mutex_init(mutex);
+}
+
+/**
+ * @brief Releases the resources of a mutex, nothing to do on Zephyr.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_destroy(danp_ftp_mutex_t *mutex)
+{
+    (void)mutex;
+}
+
+/**
+ * @brief Locks a mutex, blocking until it is available.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_lock(danp_ftp_mutex_t *mutex)
+{
+    k_mutex_lock(mutex, K_FOREVER);
+}
+
+/**
+ * @brief Unlocks a mutex.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_unlock(danp_ftp_mutex_t *mutex)
+{
+    k_mutex_unlock(mutex);
+}
+
+/**
+ * @brief Initializes a condition variable.
+ * @param cond Pointer to the condition variable to initialize.
+ */
+void danp_ftp_port_cond_init(danp_ftp_cond_t *cond)
+{
+    k_condvar_init(cond);
+}
+
+/**
+ * @brief Releases the resources of a condition variable, nothing to do on Zephyr.
+ * @param cond Pointer to the condition variable.
+ */
+void danp_ftp_port_cond_destroy(danp_ftp_cond_t *cond)
+{
+    (void)cond;
+}
+
+/**
+ * @brief Atomically unlocks a mutex and waits for the condition to be signalled.
+ * @param cond Pointer to the condition variable.
+ * @param mutex Pointer to the locked mutex.
+ */
+void danp_ftp_port_cond_wait(danp_ftp_cond_t *cond, danp_ftp_mutex_t *mutex)
+{
+    k_condvar_wait(cond, mutex, K_FOREVER);
+}
+
+/**
+ * @brief Wakes all threads waiting on a condition variable.
+ * @param cond Pointer to the condition variable.
+ */
+void danp_ftp_port_cond_broadcast(danp_ftp_cond_t *cond)
+{
+    k_condvar_broadcast(cond);
+}
+
+#else
+
+/**
+ * @brief Returns a monotonic timestamp from CLOCK_MONOTONIC.
+ * @return Time in microseconds since an unspecified starting point.
+ */
+uint64_t danp_ftp_port_time_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((uint64_t)now.tv_sec * 1000000U) + ((uint64_t)now.tv_nsec / 1000U);
+}
+
+/**
+ * @brief Suspends the calling thread, resuming the sleep after signals.
+ * @param duration_us Time to sleep in microseconds.
+ */
+void danp_ftp_port_sleep_us(uint32_t duration_us)
+{
+    struct timespec duration;
+
+    duration.tv_sec = (time_t)(duration_us / 1000000U);
+    duration.tv_nsec = (long)(duration_us % 1000000U) * 1000L;
+
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR)
+    {
+        /* Interrupted by a signal, sleep for the remaining time */
+    }
+}
+
+/**
+ * @brief Initializes a mutex.
+ * @param mutex Pointer to the mutex to initialize.
+ */
+void danp_ftp_port_mutex_init(danp_ftp_mutex_t *mutex)
+{
+    pthread_mutex_init(mutex, NULL);
+}
+
+/**
+ * @brief Releases the resources of a mutex.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_destroy(danp_ftp_mutex_t *mutex)
+{
+    pthread_mutex_destroy(mutex);
+}
+
+/**
+ * @brief Locks a mutex, blocking until it is available.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_lock(danp_ftp_mutex_t *mutex)
+{
+    pthread_mutex_lock(mutex);
+}
+
+/**
+ * @brief Unlocks a mutex.
+ * @param mutex Pointer to the mutex.
+ */
+void danp_ftp_port_mutex_unlock(danp_ftp_mutex_t *mutex)
+{
+    pthread_mutex_unlock(mutex);
+}
+
+/**
+ * @brief Initializes a condition variable.
+ * @param cond Pointer to the condition variable to initialize.
+ */
+void danp_ftp_port_cond_init(danp_ftp_cond_t *cond)
+{
+    pthread_cond_init(cond, NULL);
+}
+
+/**
+ * @brief Releases the resources of a condition variable.
+ * @param cond Pointer to the condition variable.
+ */
+void danp_ftp_port_cond_destroy(danp_ftp_cond_t *cond)
+{
+    pthread_cond_destroy(cond);
+}
+
+/**
+ * @brief Atomically unlocks a mutex and waits for the condition to be signalled.
+ * @param cond Pointer to the condition variable.
+ * @param mutex Pointer to the locked mutex.
+ */
+void danp_ftp_port_cond_wait(danp_ftp_cond_t *cond, danp_ftp_mutex_t *mutex)
+{
+    pthread_cond_wait(cond, mutex);
+}
+
+/**
+ * @brief Wakes all threads waiting on a condition variable.
+ * @param cond Pointer to the condition variable.
+ */
+void danp_ftp_port_cond_broadcast(danp_ftp_cond_t *cond)
+{
+    pthread_cond_broadcast(cond);
+}
+
+#endif
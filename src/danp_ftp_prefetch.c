@@ -0,0 +1,263 @@
+/* danp_ftp_prefetch.c - read-ahead stage running the source callback on a worker thread */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_prefetch.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Initializes a prefetch stage in front of a source callback.
+ * @param prefetch Pointer to the prefetch stage to initialize.
+ * @param handle Handle passed to the wrapped source callback.
+ * @param chunk_size Chunk size of the transfer.
+ * @param source Wrapped source callback.
+ * @param source_data User data of the wrapped source callback.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_prefetch_init(
+    danp_ftp_prefetch_t *prefetch,
+    danp_ftp_handle_t *handle,
+    uint16_t chunk_size,
+    danp_ftp_source_cb_t source,
+    void *source_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!prefetch || !source || chunk_size == 0 || chunk_size > DANP_FTP_MAX_CHUNK_SIZE)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(prefetch, 0, sizeof(danp_ftp_prefetch_t));
+
+        prefetch->source = source;
+        prefetch->source_data = source_data;
+        prefetch->handle = handle;
+        prefetch->chunk_size = chunk_size;
+
+        danp_ftp_port_mutex_init(&prefetch->lock);
+        danp_ftp_port_cond_init(&prefetch->changed);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Runs the prefetch worker until the source is exhausted or the stage is stopped.
+ * @param prefetch Pointer to the prefetch stage.
+ */
+void danp_ftp_prefetch_run(danp_ftp_prefetch_t *prefetch)
+{
+    danp_ftp_prefetch_slot_t *slot;
+    uint64_t start_us;
+    uint64_t read_us;
+
+    danp_ftp_port_mutex_lock(&prefetch->lock);
+
+    while (!prefetch->is_stopped && !prefetch->is_finished)
+    {
+        if (prefetch->count == DANP_FTP_PREFETCH_DEPTH)
+        {
+            danp_ftp_port_cond_wait(&prefetch->changed, &prefetch->lock);
+            continue;
+        }
+
+        /* The slot is owned by the worker until count is raised, so read without the lock */
+        slot = &prefetch->slots[(prefetch->head + prefetch->count) % DANP_FTP_PREFETCH_DEPTH];
+        slot->offset = prefetch->next_offset;
+        slot->more = 0;
+
+        danp_ftp_port_mutex_unlock(&prefetch->lock);
+
+        start_us = danp_ftp_port_time_us();
+        slot->length = prefetch->source(
+            prefetch->handle,
+            slot->offset,
+            slot->data,
+            prefetch->chunk_size,
+            &slot->more,
+            prefetch->source_data);
+        read_us = danp_ftp_port_time_us() - start_us;
+
+        danp_ftp_port_mutex_lock(&prefetch->lock);
+
+        slot->read_time_us = read_us;
+        prefetch->stats.read_time_us += read_us;
+        if (slot->length <= 0 || !slot->more)
+        {
+            prefetch->is_finished = true;
+        }
+        else
+        {
+            prefetch->next_offset += (size_t)slot->length;
+        }
+        prefetch->count++;
+
+        danp_ftp_port_cond_broadcast(&prefetch->changed);
+    }
+
+    danp_ftp_port_mutex_unlock(&prefetch->lock);
+}
+
+/**
+ * @brief Source callback handing out prefetched chunks in order.
+ * @param handle Pointer to the FTP handle.
+ * @param offset Offset requested by the transfer.
+ * @param data Buffer to fill.
+ * @param length Size of the buffer.
+ * @param more Set to 1 if more data follows.
+ * @param user_data Pointer to the prefetch stage.
+ * @return Bytes produced or a negative status code.
+ */
+danp_ftp_status_t danp_ftp_prefetch_source_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    uint8_t *data,
+    uint16_t length,
+    uint8_t *more,
+    void *user_data)
+{
+    danp_ftp_prefetch_t *prefetch = (danp_ftp_prefetch_t *)user_data;
+    danp_ftp_prefetch_slot_t *slot;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint64_t start_us;
+    uint64_t wait_us;
+    uint64_t read_us;
+
+    (void)handle;
+
+    for (;;)
+    {
+        if (!prefetch || !data || !more)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        start_us = danp_ftp_port_time_us();
+
+        danp_ftp_port_mutex_lock(&prefetch->lock);
+
+        while (prefetch->count == 0 && !prefetch->is_finished && !prefetch->is_stopped)
+        {
+            danp_ftp_port_cond_wait(&prefetch->changed, &prefetch->lock);
+        }
+
+        if (prefetch->count == 0)
+        {
+            danp_ftp_port_mutex_unlock(&prefetch->lock);
+            status = DANP_FTP_STATUS_ERROR;
+            break;
+        }
+
+        slot = &prefetch->slots[prefetch->head];
+
+        if (slot->offset != offset ||
+            (slot->length > 0 && slot->length > (danp_ftp_status_t)length))
+        {
+            danp_ftp_port_mutex_unlock(&prefetch->lock);
+            DANP_FTP_LOG_ERR(
+                "FTP prefetch out of step at offset %zu",
+                offset);
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        status = slot->length;
+        *more = slot->more;
+        if (status > 0)
+        {
+            memcpy(data, slot->data, (size_t)status);
+        }
+
+        prefetch->head = (prefetch->head + 1U) % DANP_FTP_PREFETCH_DEPTH;
+        prefetch->count--;
+
+        /* Whatever the source took for the chunks handed out beyond the time we blocked here
+         * was overlapped; chunks still queued are not counted */
+        wait_us = danp_ftp_port_time_us() - start_us;
+        prefetch->stats.used_read_time_us += slot->read_time_us;
+        read_us = prefetch->stats.used_read_time_us;
+        prefetch->stats.chunks++;
+        prefetch->stats.wait_time_us += wait_us;
+        prefetch->stats.hidden_time_us =
+            (read_us > prefetch->stats.wait_time_us) ? (read_us - prefetch->stats.wait_time_us) : 0;
+
+        danp_ftp_port_cond_broadcast(&prefetch->changed);
+        danp_ftp_port_mutex_unlock(&prefetch->lock);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Stops the worker.
+ * @param prefetch Pointer to the prefetch stage.
+ */
+void danp_ftp_prefetch_stop(danp_ftp_prefetch_t *prefetch)
+{
+    if (prefetch)
+    {
+        danp_ftp_port_mutex_lock(&prefetch->lock);
+        prefetch->is_stopped = true;
+        danp_ftp_port_cond_broadcast(&prefetch->changed);
+        danp_ftp_port_mutex_unlock(&prefetch->lock);
+    }
+}
+
+/**
+ * @brief Reads the prefetch statistics.
+ * @param prefetch Pointer to the prefetch stage.
+ * @param stats Pointer to store the statistics.
+ */
+void danp_ftp_prefetch_get_stats(
+    danp_ftp_prefetch_t *prefetch,
+    danp_ftp_prefetch_stats_t *stats)
+{
+    if (prefetch && stats)
+    {
+        danp_ftp_port_mutex_lock(&prefetch->lock);
+        *stats = prefetch->stats;
+        danp_ftp_port_mutex_unlock(&prefetch->lock);
+    }
+}
+
+/**
+ * @brief Releases the resources of a prefetch stage.
+ * @param prefetch Pointer to the prefetch stage.
+ */
+void danp_ftp_prefetch_deinit(danp_ftp_prefetch_t *prefetch)
+{
+    if (prefetch)
+    {
+        danp_ftp_port_cond_destroy(&prefetch->changed);
+        danp_ftp_port_mutex_destroy(&prefetch->lock);
+    }
+}
@@ -0,0 +1,268 @@
+/* danp_ftp_rate.c - token bucket rate limiting for the FTP send path */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_rate.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_FTP_RATE_US_PER_SEC              (1000000U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_ftp_rate_limiter_t *GlobalRateLimiter = NULL;
+
+/* Functions */
+
+/**
+ * @brief Initializes a token bucket rate limiter.
+ * @param limiter Pointer to the rate limiter to initialize.
+ * @param rate_bytes_per_sec Sustained rate in bytes per second.
+ * @param burst_bytes Bucket depth in bytes.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_rate_limiter_init(
+    danp_ftp_rate_limiter_t *limiter,
+    uint32_t rate_bytes_per_sec,
+    uint32_t burst_bytes)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!limiter || rate_bytes_per_sec == 0 || burst_bytes == 0)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(limiter, 0, sizeof(danp_ftp_rate_limiter_t));
+
+        limiter->rate_bytes_per_sec = rate_bytes_per_sec;
+        limiter->burst_bytes = burst_bytes;
+        limiter->tokens = (uint64_t)burst_bytes * DANP_FTP_RATE_US_PER_SEC;
+        limiter->last_update_us = danp_ftp_port_time_us();
+
+        danp_ftp_port_mutex_init(&limiter->lock);
+        limiter->is_initialized = true;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Releases the resources of a rate limiter.
+ * @param limiter Pointer to the rate limiter.
+ */
+void danp_ftp_rate_limiter_deinit(danp_ftp_rate_limiter_t *limiter)
+{
+    for (;;)
+    {
+        if (!limiter || !limiter->is_initialized)
+        {
+            break;
+        }
+
+        limiter->is_initialized = false;
+        danp_ftp_port_mutex_destroy(&limiter->lock);
+
+        break;
+    }
+}
+
+/**
+ * @brief Takes credit for sending bytes, possibly ahead of the time it becomes available.
+ * @param limiter Pointer to the rate limiter.
+ * @param bytes Number of bytes about to be sent.
+ * @return Time to wait before sending, in microseconds.
+ */
+static uint32_t danp_ftp_rate_limiter_reserve(
+    danp_ftp_rate_limiter_t *limiter,
+    size_t bytes)
+{
+    uint64_t capacity;
+    uint64_t elapsed_us;
+    uint64_t needed;
+    uint64_t deficit;
+    uint64_t now_us;
+    uint32_t wait_us = 0;
+
+    for (;;)
+    {
+        if (!limiter || !limiter->is_initialized || bytes == 0)
+        {
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&limiter->lock);
+
+        now_us = danp_ftp_port_time_us();
+        capacity = (uint64_t)limiter->burst_bytes * DANP_FTP_RATE_US_PER_SEC;
+
+        /* Refill, unless earlier callers already reserved credit from the future */
+        if (now_us > limiter->last_update_us)
+        {
+            elapsed_us = now_us - limiter->last_update_us;
+            if (elapsed_us > capacity / limiter->rate_bytes_per_sec)
+            {
+                limiter->tokens = capacity;
+            }
+            else
+            {
+                limiter->tokens += elapsed_us * limiter->rate_bytes_per_sec;
+                if (limiter->tokens > capacity)
+                {
+                    limiter->tokens = capacity;
+                }
+            }
+            limiter->last_update_us = now_us;
+        }
+
+        needed = (uint64_t)bytes * DANP_FTP_RATE_US_PER_SEC;
+        if (limiter->tokens >= needed)
+        {
+            limiter->tokens -= needed;
+        }
+        else
+        {
+            deficit = needed - limiter->tokens;
+            limiter->tokens = 0;
+            limiter->last_update_us +=
+                (deficit + limiter->rate_bytes_per_sec - 1U) / limiter->rate_bytes_per_sec;
+            wait_us = (uint32_t)(limiter->last_update_us - now_us);
+        }
+
+        danp_ftp_port_mutex_unlock(&limiter->lock);
+
+        break;
+    }
+
+    return wait_us;
+}
+
+/**
+ * @brief Sleeps out the wait of a rate limiter in slices, stopping early on a cancel.
+ * @param handle Pointer to the FTP handle.
+ * @param wait_us Time to wait in microseconds.
+ * @return Status code.
+ */
+static danp_ftp_status_t danp_ftp_rate_wait(
+    const danp_ftp_handle_t *handle,
+    uint32_t wait_us)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint32_t slice_us;
+
+    while (wait_us > 0)
+    {
+        if (danp_ftp_is_cancelled(handle))
+        {
+            status = DANP_FTP_STATUS_CANCELLED;
+            break;
+        }
+
+        slice_us = (wait_us < DANP_FTP_CANCEL_POLL_MS * 1000U) ?
+            wait_us : DANP_FTP_CANCEL_POLL_MS * 1000U;
+        danp_ftp_port_sleep_us(slice_us);
+        wait_us -= slice_us;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Takes credit for sending bytes, sleeping until the credit is available.
+ * @param limiter Pointer to the rate limiter.
+ * @param bytes Number of bytes about to be sent.
+ * @return Time slept in microseconds.
+ */
+uint32_t danp_ftp_rate_limiter_acquire(
+    danp_ftp_rate_limiter_t *limiter,
+    size_t bytes)
+{
+    uint32_t wait_us = danp_ftp_rate_limiter_reserve(limiter, bytes);
+
+    if (wait_us > 0)
+    {
+        danp_ftp_port_sleep_us(wait_us);
+    }
+
+    return wait_us;
+}
+
+/**
+ * @brief Attaches a rate limiter to an FTP handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param limiter Pointer to the rate limiter, NULL to remove it.
+ */
+void danp_ftp_set_rate_limiter(
+    danp_ftp_handle_t *handle,
+    danp_ftp_rate_limiter_t *limiter)
+{
+    if (handle)
+    {
+        handle->rate_limiter = limiter;
+    }
+}
+
+/**
+ * @brief Sets the rate limiter applied to data packets of all handles.
+ * @param limiter Pointer to the rate limiter, NULL to remove it.
+ */
+void danp_ftp_set_global_rate_limiter(danp_ftp_rate_limiter_t *limiter)
+{
+    GlobalRateLimiter = limiter;
+}
+
+/**
+ * @brief Paces a data packet through the handle and global rate limiters.
+ * @param handle Pointer to the FTP handle.
+ * @param bytes Size of the packet on the wire.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_rate_limit_packet(
+    danp_ftp_handle_t *handle,
+    size_t bytes)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (handle->rate_limiter)
+        {
+            status = danp_ftp_rate_wait(
+                handle,
+                danp_ftp_rate_limiter_reserve(handle->rate_limiter, bytes));
+            if (status < 0)
+            {
+                break;
+            }
+        }
+
+        if (GlobalRateLimiter)
+        {
+            status = danp_ftp_rate_wait(
+                handle,
+                danp_ftp_rate_limiter_reserve(GlobalRateLimiter, bytes));
+        }
+
+        break;
+    }
+
+    return status;
+}
@@ -0,0 +1,358 @@
+/* danp_ftp_sched.c - priority scheduling of concurrent transfers sharing a link */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_sched.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_FTP_SCHED_STRIDE_BASE            (1UL << 16)
+#define DANP_FTP_SCHED_ABANDON_WINDOW         (32U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Picks the class that gets the link next.
+ * @param scheduler Pointer to the scheduler, locked.
+ * @return Priority class, DANP_FTP_SCHED_CLASSES if nobody is waiting.
+ */
+static size_t danp_ftp_scheduler_pick(const danp_ftp_scheduler_t *scheduler)
+{
+    size_t selected = DANP_FTP_SCHED_CLASSES;
+    size_t i;
+
+    for (i = 0; i < DANP_FTP_SCHED_CLASSES; i++)
+    {
+        if (scheduler->waiting[i] == 0)
+        {
+            continue;
+        }
+
+        if (scheduler->mode == DANP_FTP_SCHED_MODE_STRICT)
+        {
+            selected = i;
+            break;
+        }
+
+        /* Lowest pass wins, ties go to the more urgent class */
+        if (selected == DANP_FTP_SCHED_CLASSES || scheduler->pass[i] < scheduler->pass[selected])
+        {
+            selected = i;
+        }
+    }
+
+    return selected;
+}
+
+/**
+ * @brief Moves the head of a class past the tickets given up by cancelled transfers.
+ * @param scheduler Pointer to the scheduler, locked.
+ * @param priority Priority class.
+ */
+static void danp_ftp_scheduler_skip_abandoned(
+    danp_ftp_scheduler_t *scheduler,
+    uint8_t priority)
+{
+    while (scheduler->abandoned[priority] & 1U)
+    {
+        scheduler->abandoned[priority] >>= 1;
+        scheduler->now_serving[priority]++;
+    }
+}
+
+/**
+ * @brief Queues for the link, giving up if the transfer of a handle is cancelled meanwhile.
+ * @param scheduler Pointer to the scheduler.
+ * @param priority Priority class of the transfer.
+ * @param is_first True for the first chunk of a transfer.
+ * @param handle Pointer to the FTP handle, NULL if the wait cannot be cancelled.
+ * @param wait_us Pointer to store the queueing latency in microseconds.
+ * @return True if the link was granted.
+ */
+static bool danp_ftp_scheduler_wait(
+    danp_ftp_scheduler_t *scheduler,
+    uint8_t priority,
+    bool is_first,
+    const danp_ftp_handle_t *handle,
+    uint32_t *wait_us)
+{
+    danp_ftp_sched_stats_t *stats;
+    uint64_t start_us;
+    uint32_t ticket;
+    bool is_granted = false;
+
+    *wait_us = 0;
+
+    for (;;)
+    {
+        if (!scheduler || !scheduler->is_initialized)
+        {
+            break;
+        }
+
+        if (priority > DANP_FTP_SCHED_PRIORITY_LOWEST)
+        {
+            priority = DANP_FTP_SCHED_PRIORITY_LOWEST;
+        }
+
+        danp_ftp_port_mutex_lock(&scheduler->lock);
+
+        start_us = danp_ftp_port_time_us();
+        ticket = scheduler->next_ticket[priority]++;
+
+        /* A class waking up from idle must not cash in the turns it did not use */
+        if (scheduler->waiting[priority] == 0 && scheduler->pass[priority] < scheduler->global_pass)
+        {
+            scheduler->pass[priority] = scheduler->global_pass;
+        }
+        scheduler->waiting[priority]++;
+
+        is_granted = true;
+        while (scheduler->is_busy ||
+               danp_ftp_scheduler_pick(scheduler) != priority ||
+               scheduler->now_serving[priority] != ticket)
+        {
+            /* danp_ftp_cancel() wakes the queue; a ticket too far back waits until it fits */
+            if (handle && danp_ftp_is_cancelled(handle) &&
+                ticket - scheduler->now_serving[priority] < DANP_FTP_SCHED_ABANDON_WINDOW)
+            {
+                is_granted = false;
+                break;
+            }
+
+            danp_ftp_port_cond_wait(&scheduler->changed, &scheduler->lock);
+        }
+
+        scheduler->waiting[priority]--;
+
+        if (!is_granted)
+        {
+            scheduler->abandoned[priority] |= 1UL << (ticket - scheduler->now_serving[priority]);
+            danp_ftp_scheduler_skip_abandoned(scheduler, priority);
+            danp_ftp_port_cond_broadcast(&scheduler->changed);
+            danp_ftp_port_mutex_unlock(&scheduler->lock);
+            break;
+        }
+
+        scheduler->is_busy = true;
+        scheduler->now_serving[priority]++;
+        scheduler->abandoned[priority] >>= 1;
+        danp_ftp_scheduler_skip_abandoned(scheduler, priority);
+        scheduler->global_pass = scheduler->pass[priority];
+        scheduler->pass[priority] += scheduler->stride[priority];
+
+        *wait_us = (uint32_t)(danp_ftp_port_time_us() - start_us);
+
+        stats = &scheduler->stats[priority];
+        stats->grants++;
+        stats->wait_time_us += *wait_us;
+        if (*wait_us > stats->max_wait_us)
+        {
+            stats->max_wait_us = *wait_us;
+        }
+        if (is_first)
+        {
+            stats->first_wait_us = *wait_us;
+        }
+
+        danp_ftp_port_mutex_unlock(&scheduler->lock);
+
+        break;
+    }
+
+    return is_granted;
+}
+
+/**
+ * @brief Initializes a transfer scheduler for one link.
+ * @param scheduler Pointer to the scheduler to initialize.
+ * @param config Pointer to the configuration, NULL for strict priority.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_scheduler_init(
+    danp_ftp_scheduler_t *scheduler,
+    const danp_ftp_scheduler_config_t *config)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint16_t weight;
+    size_t i;
+
+    for (;;)
+    {
+        if (!scheduler)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(scheduler, 0, sizeof(danp_ftp_scheduler_t));
+
+        scheduler->mode = config ? config->mode : DANP_FTP_SCHED_MODE_STRICT;
+        for (i = 0; i < DANP_FTP_SCHED_CLASSES; i++)
+        {
+            weight = (config && config->weights[i] > 0) ? config->weights[i] : 1U;
+            scheduler->stride[i] = (uint32_t)(DANP_FTP_SCHED_STRIDE_BASE / weight);
+        }
+
+        danp_ftp_port_mutex_init(&scheduler->lock);
+        danp_ftp_port_cond_init(&scheduler->changed);
+        scheduler->is_initialized = true;
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Releases the resources of a scheduler.
+ * @param scheduler Pointer to the scheduler.
+ */
+void danp_ftp_scheduler_deinit(danp_ftp_scheduler_t *scheduler)
+{
+    if (scheduler && scheduler->is_initialized)
+    {
+        scheduler->is_initialized = false;
+        danp_ftp_port_cond_destroy(&scheduler->changed);
+        danp_ftp_port_mutex_destroy(&scheduler->lock);
+    }
+}
+
+/**
+ * @brief Waits until the scheduler grants the link to a transfer of the given class.
+ * @param scheduler Pointer to the scheduler.
+ * @param priority Priority class of the transfer.
+ * @param is_first True for the first chunk of a transfer.
+ * @return Queueing latency in microseconds.
+ */
+uint32_t danp_ftp_scheduler_acquire(
+    danp_ftp_scheduler_t *scheduler,
+    uint8_t priority,
+    bool is_first)
+{
+    uint32_t wait_us;
+
+    danp_ftp_scheduler_wait(scheduler, priority, is_first, NULL, &wait_us);
+
+    return wait_us;
+}
+
+/**
+ * @brief Returns the link after a chunk exchange.
+ * @param scheduler Pointer to the scheduler.
+ */
+void danp_ftp_scheduler_release(danp_ftp_scheduler_t *scheduler)
+{
+    if (scheduler && scheduler->is_initialized)
+    {
+        danp_ftp_port_mutex_lock(&scheduler->lock);
+        scheduler->is_busy = false;
+        danp_ftp_port_cond_broadcast(&scheduler->changed);
+        danp_ftp_port_mutex_unlock(&scheduler->lock);
+    }
+}
+
+/**
+ * @brief Reads the queueing statistics of a priority class.
+ * @param scheduler Pointer to the scheduler.
+ * @param priority Priority class.
+ * @param stats Pointer to store the statistics.
+ */
+void danp_ftp_scheduler_get_stats(
+    danp_ftp_scheduler_t *scheduler,
+    uint8_t priority,
+    danp_ftp_sched_stats_t *stats)
+{
+    if (scheduler && scheduler->is_initialized && stats && priority < DANP_FTP_SCHED_CLASSES)
+    {
+        danp_ftp_port_mutex_lock(&scheduler->lock);
+        *stats = scheduler->stats[priority];
+        danp_ftp_port_mutex_unlock(&scheduler->lock);
+    }
+}
+
+/**
+ * @brief Attaches a scheduler and priority class to an FTP handle.
+ * @param handle Pointer to the initialized FTP handle.
+ * @param scheduler Pointer to the scheduler, NULL to remove it.
+ * @param priority Priority class.
+ */
+void danp_ftp_set_priority(
+    danp_ftp_handle_t *handle,
+    danp_ftp_scheduler_t *scheduler,
+    uint8_t priority)
+{
+    if (handle)
+    {
+        handle->scheduler = scheduler;
+        handle->priority = (priority > DANP_FTP_SCHED_PRIORITY_LOWEST) ?
+            (uint8_t)DANP_FTP_SCHED_PRIORITY_LOWEST : priority;
+    }
+}
+
+/**
+ * @brief Waits for the scheduler of a handle before a chunk exchange, unless cancelled.
+ * @param handle Pointer to the FTP handle.
+ * @param is_first True for the first chunk of a transfer.
+ */
+void danp_ftp_schedule_begin(
+    danp_ftp_handle_t *handle,
+    bool is_first)
+{
+    uint32_t wait_us;
+
+    if (handle->scheduler)
+    {
+        handle->has_link = danp_ftp_scheduler_wait(
+            handle->scheduler,
+            handle->priority,
+            is_first,
+            handle,
+            &wait_us);
+    }
+}
+
+/**
+ * @brief Returns the link to the scheduler of a handle after a chunk exchange.
+ * @param handle Pointer to the FTP handle.
+ */
+void danp_ftp_schedule_end(danp_ftp_handle_t *handle)
+{
+    if (handle->scheduler && handle->has_link)
+    {
+        handle->has_link = false;
+        danp_ftp_scheduler_release(handle->scheduler);
+    }
+}
+
+/**
+ * @brief Wakes a transfer of a handle queued in its scheduler so it sees the cancel.
+ * @param handle Pointer to the FTP handle.
+ */
+void danp_ftp_schedule_wake(danp_ftp_handle_t *handle)
+{
+    danp_ftp_scheduler_t *scheduler = handle->scheduler;
+
+    if (scheduler && scheduler->is_initialized)
+    {
+        danp_ftp_port_mutex_lock(&scheduler->lock);
+        danp_ftp_port_cond_broadcast(&scheduler->changed);
+        danp_ftp_port_mutex_unlock(&scheduler->lock);
+    }
+}
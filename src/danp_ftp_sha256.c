@@ -0,0 +1,231 @@
+/* danp_ftp_sha256.c - incremental SHA-256 for chunk and file digests */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_sha256.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define DANP_FTP_SHA256_ROTR(x, n)            (((x) >> (n)) | ((x) << (32U - (n))))
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static const uint32_t Sha256RoundConstants[64] = {
+    0x428A2F98U, 0x71374491U, 0xB5C0FBCFU, 0xE9B5DBA5U, 0x3956C25BU, 0x59F111F1U, 0x923F82A4U,
+    0xAB1C5ED5U, 0xD807AA98U, 0x12835B01U, 0x243185BEU, 0x550C7DC3U, 0x72BE5D74U, 0x80DEB1FEU,
+    0x9BDC06A7U, 0xC19BF174U, 0xE49B69C1U, 0xEFBE4786U, 0x0FC19DC6U, 0x240CA1CCU, 0x2DE92C6FU,
+    0x4A7484AAU, 0x5CB0A9DCU, 0x76F988DAU, 0x983E5152U, 0xA831C66DU, 0xB00327C8U, 0xBF597FC7U,
+    0xC6E00BF3U, 0xD5A79147U, 0x06CA6351U, 0x14292967U, 0x27B70A85U, 0x2E1B2138U, 0x4D2C6DFCU,
+    0x53380D13U, 0x650A7354U, 0x766A0ABBU, 0x81C2C92EU, 0x92722C85U, 0xA2BFE8A1U, 0xA81A664BU,
+    0xC24B8B70U, 0xC76C51A3U, 0xD192E819U, 0xD6990624U, 0xF40E3585U, 0x106AA070U, 0x19A4C116U,
+    0x1E376C08U, 0x2748774CU, 0x34B0BCB5U, 0x391C0CB3U, 0x4ED8AA4AU, 0x5B9CCA4FU, 0x682E6FF3U,
+    0x748F82EEU, 0x78A5636FU, 0x84C87814U, 0x8CC70208U, 0x90BEFFFAU, 0xA4506CEBU, 0xBEF9A3F7U,
+    0xC67178F2U,
+};
+
+/* Functions */
+
+/**
+ * @brief Compresses one 64-byte block into the hash state.
+ *
+ * The message schedule is kept as a rolling window of 16 words instead of all 64, which keeps
+ * this leaf function, the deepest frame of a digest-verified transfer, small.
+ *
+ * @param state Hash state.
+ * @param block Block to compress.
+ */
+static void danp_ftp_sha256_compress(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[16];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+    size_t i;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = ((uint32_t)block[i * 4] << 24) | ((uint32_t)block[i * 4 + 1] << 16) |
+               ((uint32_t)block[i * 4 + 2] << 8) | (uint32_t)block[i * 4 + 3];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        /* w[i % 16] still holds w[i - 16] until it is replaced by w[i] */
+        if (i >= 16)
+        {
+            t1 = DANP_FTP_SHA256_ROTR(w[(i - 2) & 15U], 17) ^
+                 DANP_FTP_SHA256_ROTR(w[(i - 2) & 15U], 19) ^ (w[(i - 2) & 15U] >> 10);
+            t2 = DANP_FTP_SHA256_ROTR(w[(i - 15) & 15U], 7) ^
+                 DANP_FTP_SHA256_ROTR(w[(i - 15) & 15U], 18) ^ (w[(i - 15) & 15U] >> 3);
+            w[i & 15U] += t2 + w[(i - 7) & 15U] + t1;
+        }
+
+        t1 = h + (DANP_FTP_SHA256_ROTR(e, 6) ^ DANP_FTP_SHA256_ROTR(e, 11) ^
+                  DANP_FTP_SHA256_ROTR(e, 25)) +
+             ((e & f) ^ (~e & g)) + Sha256RoundConstants[i] + w[i & 15U];
+        t2 = (DANP_FTP_SHA256_ROTR(a, 2) ^ DANP_FTP_SHA256_ROTR(a, 13) ^
+              DANP_FTP_SHA256_ROTR(a, 22)) +
+             ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+/**
+ * @brief Starts a SHA-256 computation.
+ * @param sha Pointer to the hash context.
+ */
+void danp_ftp_sha256_init(danp_ftp_sha256_t *sha)
+{
+    sha->state[0] = 0x6A09E667U;
+    sha->state[1] = 0xBB67AE85U;
+    sha->state[2] = 0x3C6EF372U;
+    sha->state[3] = 0xA54FF53AU;
+    sha->state[4] = 0x510E527FU;
+    sha->state[5] = 0x9B05688CU;
+    sha->state[6] = 0x1F83D9ABU;
+    sha->state[7] = 0x5BE0CD19U;
+    sha->length = 0;
+    sha->block_used = 0;
+}
+
+/**
+ * @brief Feeds data into a SHA-256 computation.
+ * @param sha Pointer to the hash context.
+ * @param data Data to hash.
+ * @param length Size of the data.
+ */
+void danp_ftp_sha256_update(
+    danp_ftp_sha256_t *sha,
+    const uint8_t *data,
+    size_t length)
+{
+    size_t take;
+
+    sha->length += length;
+
+    /* Top up a pending partial block first */
+    if (sha->block_used > 0)
+    {
+        take = DANP_FTP_SHA256_BLOCK_SIZE - sha->block_used;
+        if (take > length)
+        {
+            take = length;
+        }
+        memcpy(&sha->block[sha->block_used], data, take);
+        sha->block_used += take;
+        data += take;
+        length -= take;
+
+        if (sha->block_used < DANP_FTP_SHA256_BLOCK_SIZE)
+        {
+            return;
+        }
+
+        danp_ftp_sha256_compress(sha->state, sha->block);
+        sha->block_used = 0;
+    }
+
+    /* Whole blocks straight from the caller's buffer */
+    while (length >= DANP_FTP_SHA256_BLOCK_SIZE)
+    {
+        danp_ftp_sha256_compress(sha->state, data);
+        data += DANP_FTP_SHA256_BLOCK_SIZE;
+        length -= DANP_FTP_SHA256_BLOCK_SIZE;
+    }
+
+    if (length > 0)
+    {
+        memcpy(sha->block, data, length);
+        sha->block_used = length;
+    }
+}
+
+/**
+ * @brief Finishes a SHA-256 computation.
+ * @param sha Pointer to the hash context.
+ * @param digest Buffer of DANP_FTP_SHA256_SIZE bytes for the digest.
+ */
+void danp_ftp_sha256_final(
+    danp_ftp_sha256_t *sha,
+    uint8_t *digest)
+{
+    uint64_t bit_length = sha->length * 8U;
+    size_t i;
+
+    sha->block[sha->block_used++] = 0x80;
+    if (sha->block_used > DANP_FTP_SHA256_BLOCK_SIZE - 8U)
+    {
+        memset(&sha->block[sha->block_used], 0, DANP_FTP_SHA256_BLOCK_SIZE - sha->block_used);
+        danp_ftp_sha256_compress(sha->state, sha->block);
+        sha->block_used = 0;
+    }
+    memset(&sha->block[sha->block_used], 0, DANP_FTP_SHA256_BLOCK_SIZE - 8U - sha->block_used);
+
+    for (i = 0; i < 8; i++)
+    {
+        sha->block[DANP_FTP_SHA256_BLOCK_SIZE - 1U - i] = (uint8_t)(bit_length >> (i * 8U));
+    }
+    danp_ftp_sha256_compress(sha->state, sha->block);
+
+    for (i = 0; i < 8; i++)
+    {
+        digest[i * 4] = (uint8_t)(sha->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(sha->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(sha->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)sha->state[i];
+    }
+}
+
+/**
+ * @brief Hashes a buffer in one call.
+ * @param data Data to hash.
+ * @param length Size of the data.
+ * @param digest Buffer of DANP_FTP_SHA256_SIZE bytes for the digest.
+ */
+void danp_ftp_sha256(
+    const uint8_t *data,
+    size_t length,
+    uint8_t *digest)
+{
+    danp_ftp_sha256_t sha;
+
+    danp_ftp_sha256_init(&sha);
+    danp_ftp_sha256_update(&sha, data, length);
+    danp_ftp_sha256_final(&sha, digest);
+}
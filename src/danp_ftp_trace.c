@@ -0,0 +1,120 @@
+/* danp_ftp_trace.c - binary packet trace ring buffer */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_trace.h"
+#include "danp/ftp/danp_ftp_port.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#if (DANP_FTP_TRACE_BUFFER_SIZE & (DANP_FTP_TRACE_BUFFER_SIZE - 1)) != 0
+#error "CONFIG_DANP_FTP_TRACE_BUFFER_SIZE must be a power of two"
+#endif
+
+#define DANP_FTP_TRACE_MASK                   (DANP_FTP_TRACE_BUFFER_SIZE - 1U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_ftp_trace_record_t TraceBuffer[DANP_FTP_TRACE_BUFFER_SIZE];
+static uint32_t TraceHead = 0;
+
+/* Functions */
+
+/**
+ * @brief Appends a packet event to the trace ring buffer.
+ * @param direction DANP_FTP_TRACE_DIRECTION_TX or DANP_FTP_TRACE_DIRECTION_RX.
+ * @param handle Pointer to the FTP handle.
+ * @param type Packet type.
+ * @param flags Packet flags.
+ * @param sequence_number Packet sequence number.
+ * @param payload_length Packet payload length.
+ */
+void danp_ftp_trace_record(
+    uint8_t direction,
+    const danp_ftp_handle_t *handle,
+    uint8_t type,
+    uint8_t flags,
+    uint16_t sequence_number,
+    uint16_t payload_length)
+{
+    uint32_t index = __atomic_fetch_add(&TraceHead, 1U, __ATOMIC_RELAXED);
+    danp_ftp_trace_record_t *record = &TraceBuffer[index & DANP_FTP_TRACE_MASK];
+
+    /* Mark the slot as in progress so readers skip it */
+    __atomic_store_n(&record->index, 0U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    record->timestamp_us = (uint32_t)danp_ftp_port_time_us();
+    record->sequence_number = sequence_number;
+    record->payload_length = payload_length;
+    record->dst_node = handle->dst_node;
+    record->type = type;
+    record->flags = flags;
+    record->direction = direction;
+
+    __atomic_store_n(&record->index, index + 1U, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copies the most recent trace records out of the ring buffer.
+ * @param records Buffer for the copied records.
+ * @param max_records Capacity of the buffer.
+ * @return Number of records copied.
+ */
+size_t danp_ftp_trace_snapshot(
+    danp_ftp_trace_record_t *records,
+    size_t max_records)
+{
+    size_t copied = 0;
+    uint32_t head;
+    uint32_t first;
+    uint32_t index;
+
+    for (;;)
+    {
+        if (!records || max_records == 0)
+        {
+            break;
+        }
+
+        head = __atomic_load_n(&TraceHead, __ATOMIC_ACQUIRE);
+        first = head > DANP_FTP_TRACE_BUFFER_SIZE ? head - DANP_FTP_TRACE_BUFFER_SIZE : 0U;
+        if (head - first > max_records)
+        {
+            first = head - (uint32_t)max_records;
+        }
+
+        for (index = first; index != head; index++)
+        {
+            const danp_ftp_trace_record_t *slot = &TraceBuffer[index & DANP_FTP_TRACE_MASK];
+            uint32_t before = __atomic_load_n(&slot->index, __ATOMIC_ACQUIRE);
+
+            memcpy(&records[copied], slot, sizeof(danp_ftp_trace_record_t));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+            /* Keep the copy only if no writer touched the slot meanwhile */
+            if (before == index + 1U && __atomic_load_n(&slot->index, __ATOMIC_RELAXED) == before)
+            {
+                records[copied].index = before;
+                copied++;
+            }
+        }
+
+        break;
+    }
+
+    return copied;
+}
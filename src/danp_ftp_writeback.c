@@ -0,0 +1,320 @@
+/* danp_ftp_writeback.c - write-behind queue between the receive path and a slow sink */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_writeback.h"
+#include "danp_ftp_internal.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+
+/* Functions */
+
+/**
+ * @brief Initializes a write-behind queue in front of a sink callback.
+ * @param writeback Pointer to the queue to initialize.
+ * @param handle Handle passed to the wrapped sink callback.
+ * @param sink Wrapped sink callback.
+ * @param sink_data User data of the wrapped sink callback.
+ * @return Status code.
+ */
+danp_ftp_status_t danp_ftp_writeback_init(
+    danp_ftp_writeback_t *writeback,
+    danp_ftp_handle_t *handle,
+    danp_ftp_sink_cb_t sink,
+    void *sink_data)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!writeback || !sink)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        memset(writeback, 0, sizeof(danp_ftp_writeback_t));
+
+        writeback->sink = sink;
+        writeback->sink_data = sink_data;
+        writeback->handle = handle;
+        writeback->result = DANP_FTP_STATUS_OK;
+
+        danp_ftp_port_mutex_init(&writeback->lock);
+        danp_ftp_port_cond_init(&writeback->changed);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Runs the write-behind worker until the final chunk is written or the queue is stopped.
+ * @param writeback Pointer to the queue.
+ */
+void danp_ftp_writeback_run(danp_ftp_writeback_t *writeback)
+{
+    danp_ftp_writeback_slot_t *slot;
+    danp_ftp_status_t sink_result;
+    uint64_t start_us;
+    uint64_t sink_us;
+
+    danp_ftp_port_mutex_lock(&writeback->lock);
+
+    while (!writeback->is_stopped && !writeback->is_finished)
+    {
+        if (writeback->count == 0)
+        {
+            danp_ftp_port_cond_wait(&writeback->changed, &writeback->lock);
+            continue;
+        }
+
+        /* The head slot stays counted while it is written, so the receive path cannot reuse it */
+        slot = &writeback->slots[writeback->head];
+        sink_result = DANP_FTP_STATUS_OK;
+        sink_us = 0;
+
+        if (writeback->result == DANP_FTP_STATUS_OK)
+        {
+            danp_ftp_port_mutex_unlock(&writeback->lock);
+
+            start_us = danp_ftp_port_time_us();
+            sink_result = writeback->sink(
+                writeback->handle,
+                slot->offset,
+                slot->data,
+                slot->length,
+                slot->more,
+                writeback->sink_data);
+            sink_us = danp_ftp_port_time_us() - start_us;
+
+            danp_ftp_port_mutex_lock(&writeback->lock);
+        }
+
+        if (sink_result < 0 && writeback->result == DANP_FTP_STATUS_OK)
+        {
+            writeback->result = sink_result;
+            writeback->error_offset = slot->offset;
+        }
+        if (!slot->more)
+        {
+            writeback->is_finished = true;
+        }
+
+        writeback->stats.chunks++;
+        writeback->stats.sink_time_us += sink_us;
+        writeback->head = (writeback->head + 1U) % DANP_FTP_WRITEBACK_DEPTH;
+        writeback->count--;
+
+        danp_ftp_port_cond_broadcast(&writeback->changed);
+    }
+
+    danp_ftp_port_mutex_unlock(&writeback->lock);
+}
+
+/**
+ * @brief Sink callback queueing received chunks for the worker.
+ * @param handle Pointer to the FTP handle.
+ * @param offset File offset of the chunk.
+ * @param data Received data.
+ * @param length Size of the received data.
+ * @param more 0 for the final chunk.
+ * @param user_data Pointer to the queue.
+ * @return Bytes accepted or the first sink error.
+ */
+danp_ftp_status_t danp_ftp_writeback_sink_cb(
+    danp_ftp_handle_t *handle,
+    size_t offset,
+    const uint8_t *data,
+    uint16_t length,
+    uint8_t more,
+    void *user_data)
+{
+    danp_ftp_writeback_t *writeback = (danp_ftp_writeback_t *)user_data;
+    danp_ftp_writeback_slot_t *slot;
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+    uint64_t start_us;
+
+    (void)handle;
+
+    for (;;)
+    {
+        if (!writeback || (!data && length > 0) || length > DANP_FTP_MAX_CHUNK_SIZE)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&writeback->lock);
+
+        start_us = danp_ftp_port_time_us();
+        while (writeback->count == DANP_FTP_WRITEBACK_DEPTH &&
+               writeback->result == DANP_FTP_STATUS_OK &&
+               !writeback->is_stopped)
+        {
+            danp_ftp_port_cond_wait(&writeback->changed, &writeback->lock);
+        }
+        writeback->stats.stall_time_us += danp_ftp_port_time_us() - start_us;
+
+        /* A failure behind an already sent ACK surfaces here and aborts the transfer */
+        if (writeback->result < 0)
+        {
+            DANP_FTP_LOG_ERR(
+                "FTP write-behind sink failed at offset %zu: %d",
+                writeback->error_offset,
+                writeback->result);
+            status = writeback->result;
+            danp_ftp_port_mutex_unlock(&writeback->lock);
+            break;
+        }
+
+        if (writeback->is_stopped || writeback->is_finished)
+        {
+            status = DANP_FTP_STATUS_ERROR;
+            danp_ftp_port_mutex_unlock(&writeback->lock);
+            break;
+        }
+
+        slot = &writeback->slots[(writeback->head + writeback->count) % DANP_FTP_WRITEBACK_DEPTH];
+        if (length > 0)
+        {
+            memcpy(slot->data, data, length);
+        }
+        slot->offset = offset;
+        slot->length = length;
+        slot->more = more;
+
+        writeback->count++;
+        if (writeback->count > writeback->stats.max_queued)
+        {
+            writeback->stats.max_queued = (uint32_t)writeback->count;
+        }
+
+        danp_ftp_port_cond_broadcast(&writeback->changed);
+
+        /* The final ACK is the success report, so hold it until everything is written */
+        if (!more)
+        {
+            while (writeback->count > 0 && !writeback->is_stopped)
+            {
+                danp_ftp_port_cond_wait(&writeback->changed, &writeback->lock);
+            }
+
+            if (writeback->result < 0)
+            {
+                status = writeback->result;
+            }
+            else if (writeback->count > 0)
+            {
+                status = DANP_FTP_STATUS_ERROR;
+            }
+        }
+
+        if (status == DANP_FTP_STATUS_OK)
+        {
+            status = (danp_ftp_status_t)length;
+        }
+
+        danp_ftp_port_mutex_unlock(&writeback->lock);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Waits until every queued chunk has been written.
+ * @param writeback Pointer to the queue.
+ * @return The first sink error, or DANP_FTP_STATUS_OK.
+ */
+danp_ftp_status_t danp_ftp_writeback_flush(danp_ftp_writeback_t *writeback)
+{
+    danp_ftp_status_t status = DANP_FTP_STATUS_OK;
+
+    for (;;)
+    {
+        if (!writeback)
+        {
+            status = DANP_FTP_STATUS_INVALID_PARAM;
+            break;
+        }
+
+        danp_ftp_port_mutex_lock(&writeback->lock);
+
+        while (writeback->count > 0 && !writeback->is_stopped)
+        {
+            danp_ftp_port_cond_wait(&writeback->changed, &writeback->lock);
+        }
+
+        status = writeback->result;
+
+        danp_ftp_port_mutex_unlock(&writeback->lock);
+
+        break;
+    }
+
+    return status;
+}
+
+/**
+ * @brief Stops the worker.
+ * @param writeback Pointer to the queue.
+ */
+void danp_ftp_writeback_stop(danp_ftp_writeback_t *writeback)
+{
+    if (writeback)
+    {
+        danp_ftp_port_mutex_lock(&writeback->lock);
+        writeback->is_stopped = true;
+        danp_ftp_port_cond_broadcast(&writeback->changed);
+        danp_ftp_port_mutex_unlock(&writeback->lock);
+    }
+}
+
+/**
+ * @brief Reads the write-behind statistics.
+ * @param writeback Pointer to the queue.
+ * @param stats Pointer to store the statistics.
+ */
+void danp_ftp_writeback_get_stats(
+    danp_ftp_writeback_t *writeback,
+    danp_ftp_writeback_stats_t *stats)
+{
+    if (writeback && stats)
+    {
+        danp_ftp_port_mutex_lock(&writeback->lock);
+        *stats = writeback->stats;
+        danp_ftp_port_mutex_unlock(&writeback->lock);
+    }
+}
+
+/**
+ * @brief Releases the resources of a write-behind queue.
+ * @param writeback Pointer to the queue.
+ */
+void danp_ftp_writeback_deinit(danp_ftp_writeback_t *writeback)
+{
+    if (writeback)
+    {
+        danp_ftp_port_cond_destroy(&writeback->changed);
+        danp_ftp_port_mutex_destroy(&writeback->lock);
+    }
+}
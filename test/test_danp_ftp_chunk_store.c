@@ -0,0 +1,296 @@
+/* test_danp_ftp_chunk_store.c - tests of the content-addressed chunk store */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#include "danp/ftp/danp_ftp_chunk_store.h"
+#include "unity.h"
+#include <string.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define TEST_CAPACITY                         (4U)
+#define TEST_CHUNK_SIZE                       (16U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_ftp_chunk_store_t Store;
+static danp_ftp_chunk_entry_t Entries[TEST_CAPACITY];
+static uint8_t Data[TEST_CAPACITY * TEST_CHUNK_SIZE];
+
+/* Functions */
+
+/**
+ * @brief Builds a hash whose bucket is `key % TEST_CAPACITY`, told apart by `tag`.
+ * @param hash Buffer of DANP_FTP_SHA256_SIZE bytes.
+ * @param key Bucket key, stored in the first four bytes.
+ * @param tag Distinguishes hashes with the same key.
+ */
+static void test_make_hash(uint8_t *hash, uint32_t key, uint8_t tag)
+{
+    memset(hash, tag, DANP_FTP_SHA256_SIZE);
+    hash[0] = (uint8_t)(key >> 24);
+    hash[1] = (uint8_t)(key >> 16);
+    hash[2] = (uint8_t)(key >> 8);
+    hash[3] = (uint8_t)key;
+}
+
+/**
+ * @brief Reserves and fills an entry for a crafted hash.
+ * @param hash SHA-256 of the chunk.
+ * @param fill Byte the chunk is filled with.
+ * @return Entry index.
+ */
+static danp_ftp_status_t test_store(const uint8_t *hash, uint8_t fill)
+{
+    uint8_t chunk[TEST_CHUNK_SIZE];
+    danp_ftp_status_t index;
+
+    memset(chunk, fill, sizeof(chunk));
+    index = danp_ftp_chunk_store_reserve(&Store, hash);
+    TEST_ASSERT_TRUE(index >= 0);
+    TEST_ASSERT_EQUAL(
+        DANP_FTP_STATUS_OK,
+        danp_ftp_chunk_store_fill(&Store, (size_t)index, chunk, sizeof(chunk)));
+
+    return index;
+}
+
+/**
+ * @brief Counts the entries chained in a bucket.
+ * @param bucket Bucket index.
+ * @return Number of entries in the chain.
+ */
+static size_t test_bucket_length(size_t bucket)
+{
+    uint16_t index = Store.entries[bucket].bucket_head;
+    size_t length = 0;
+
+    while (index != DANP_FTP_CHUNK_STORE_NONE && length <= TEST_CAPACITY)
+    {
+        length++;
+        index = Store.entries[index].bucket_next;
+    }
+
+    return length;
+}
+
+/**
+ * @brief Counts the bucket chain links that carry a hash.
+ * @param hash SHA-256 to look for.
+ * @return Number of entries with the hash in its bucket chain.
+ */
+static size_t test_hash_links(const uint8_t *hash)
+{
+    size_t bucket;
+    size_t links = 0;
+    uint16_t index;
+
+    bucket = (((size_t)hash[0] << 24) | ((size_t)hash[1] << 16) | ((size_t)hash[2] << 8) |
+              (size_t)hash[3]) % TEST_CAPACITY;
+
+    for (index = Store.entries[bucket].bucket_head;
+         index != DANP_FTP_CHUNK_STORE_NONE;
+         index = Store.entries[index].bucket_next)
+    {
+        if (memcmp(Store.entries[index].hash, hash, DANP_FTP_SHA256_SIZE) == 0)
+        {
+            links++;
+        }
+    }
+
+    return links;
+}
+
+/**
+ * @brief Checks that an entry holds a chunk filled with one byte.
+ * @param index Entry index.
+ * @param fill Expected fill byte.
+ */
+static void test_expect_chunk(danp_ftp_status_t index, uint8_t fill)
+{
+    uint8_t expected[TEST_CHUNK_SIZE];
+    const uint8_t *chunk;
+    uint16_t length = 0;
+
+    memset(expected, fill, sizeof(expected));
+    chunk = danp_ftp_chunk_store_data(&Store, (size_t)index, &length);
+    TEST_ASSERT_NOT_NULL(chunk);
+    TEST_ASSERT_EQUAL_UINT16(TEST_CHUNK_SIZE, length);
+    TEST_ASSERT_EQUAL_MEMORY(expected, chunk, TEST_CHUNK_SIZE);
+}
+
+void setUp(void)
+{
+    TEST_ASSERT_EQUAL(
+        DANP_FTP_STATUS_OK,
+        danp_ftp_chunk_store_init(&Store, Entries, TEST_CAPACITY, Data, TEST_CHUNK_SIZE));
+}
+
+void tearDown(void)
+{
+}
+
+void test_chunk_store_should_evictLeastRecentlyUsed_when_full(void)
+{
+    uint8_t hashes[TEST_CAPACITY + 1U][DANP_FTP_SHA256_SIZE];
+    danp_ftp_status_t index[TEST_CAPACITY + 1U];
+    size_t i;
+
+    for (i = 0; i <= TEST_CAPACITY; i++)
+    {
+        test_make_hash(hashes[i], (uint32_t)i, (uint8_t)(0x10U + i));
+    }
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        index[i] = test_store(hashes[i], (uint8_t)i);
+    }
+
+    /* Touching the oldest entry makes the second one the least recently used */
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+
+    index[TEST_CAPACITY] = test_store(hashes[TEST_CAPACITY], 0xEE);
+
+    TEST_ASSERT_EQUAL(index[1], index[TEST_CAPACITY]);
+    TEST_ASSERT_EQUAL_UINT32(1, Store.stats.evictions);
+    TEST_ASSERT_EQUAL_size_t(TEST_CAPACITY, Store.count);
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_FILE_NOT_FOUND, danp_ftp_chunk_store_find(&Store, hashes[1]));
+
+    /* Then the third one, untouched since it was stored */
+    test_make_hash(hashes[1], 1, 0x55);
+    TEST_ASSERT_EQUAL(index[2], test_store(hashes[1], 0x55));
+    TEST_ASSERT_EQUAL_UINT32(2, Store.stats.evictions);
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_FILE_NOT_FOUND, danp_ftp_chunk_store_find(&Store, hashes[2]));
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+    TEST_ASSERT_EQUAL(index[3], danp_ftp_chunk_store_find(&Store, hashes[3]));
+    test_expect_chunk(index[TEST_CAPACITY], 0xEE);
+    test_expect_chunk(index[2], 0x55);
+}
+
+void test_chunk_store_should_unlinkEvictedEntry_from_sharedBucket(void)
+{
+    uint8_t hashes[TEST_CAPACITY + 3U][DANP_FTP_SHA256_SIZE];
+    danp_ftp_status_t index[TEST_CAPACITY + 3U];
+    size_t i;
+
+    /* Three hashes share bucket 0, chained newest first: 2 -> 1 -> 0 */
+    test_make_hash(hashes[0], 0, 0xA0);
+    test_make_hash(hashes[1], TEST_CAPACITY, 0xA1);
+    test_make_hash(hashes[2], 2U * TEST_CAPACITY, 0xA2);
+    test_make_hash(hashes[3], 1, 0xA3);
+    test_make_hash(hashes[4], 2, 0xA4);
+    test_make_hash(hashes[5], 3, 0xA5);
+    test_make_hash(hashes[6], 3U * TEST_CAPACITY, 0xA6);
+
+    for (i = 0; i < TEST_CAPACITY; i++)
+    {
+        index[i] = test_store(hashes[i], (uint8_t)i);
+    }
+    TEST_ASSERT_EQUAL_size_t(3, test_bucket_length(0));
+
+    /* Middle of the chain */
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+    index[4] = test_store(hashes[4], 4);
+    TEST_ASSERT_EQUAL(index[1], index[4]);
+    TEST_ASSERT_EQUAL_size_t(2, test_bucket_length(0));
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_FILE_NOT_FOUND, danp_ftp_chunk_store_find(&Store, hashes[1]));
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+    TEST_ASSERT_EQUAL(index[2], danp_ftp_chunk_store_find(&Store, hashes[2]));
+
+    /* Head of the chain */
+    TEST_ASSERT_EQUAL(index[3], danp_ftp_chunk_store_find(&Store, hashes[3]));
+    TEST_ASSERT_EQUAL(index[4], danp_ftp_chunk_store_find(&Store, hashes[4]));
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+    index[5] = test_store(hashes[5], 5);
+    TEST_ASSERT_EQUAL(index[2], index[5]);
+    TEST_ASSERT_EQUAL_size_t(1, test_bucket_length(0));
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_FILE_NOT_FOUND, danp_ftp_chunk_store_find(&Store, hashes[2]));
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+
+    /* Alone in its bucket, then the shared bucket grows again */
+    index[6] = test_store(hashes[6], 6);
+    TEST_ASSERT_EQUAL(index[3], index[6]);
+    TEST_ASSERT_EQUAL_size_t(0, test_bucket_length(1));
+    TEST_ASSERT_EQUAL_size_t(2, test_bucket_length(0));
+    TEST_ASSERT_EQUAL(index[6], danp_ftp_chunk_store_find(&Store, hashes[6]));
+    TEST_ASSERT_EQUAL(index[0], danp_ftp_chunk_store_find(&Store, hashes[0]));
+    test_expect_chunk(index[6], 6);
+    test_expect_chunk(index[0], 0);
+}
+
+void test_chunk_store_should_shareEntry_when_hashRepeatsInWindow(void)
+{
+    uint8_t chunk[TEST_CHUNK_SIZE];
+    uint8_t first[DANP_FTP_SHA256_SIZE];
+    uint8_t second[DANP_FTP_SHA256_SIZE];
+    danp_ftp_status_t index;
+
+    memset(chunk, 0x42, sizeof(chunk));
+    index = danp_ftp_chunk_store_insert(&Store, chunk, sizeof(chunk), first);
+    TEST_ASSERT_TRUE(index >= 0);
+
+    memset(chunk, 0x43, sizeof(chunk));
+    TEST_ASSERT_TRUE(danp_ftp_chunk_store_insert(&Store, chunk, sizeof(chunk), NULL) >= 0);
+
+    memset(chunk, 0x42, sizeof(chunk));
+    TEST_ASSERT_EQUAL(index, danp_ftp_chunk_store_insert(&Store, chunk, sizeof(chunk), second));
+
+    /* One entry, chained once, data stored once */
+    TEST_ASSERT_EQUAL_MEMORY(first, second, DANP_FTP_SHA256_SIZE);
+    TEST_ASSERT_EQUAL_size_t(2, Store.count);
+    TEST_ASSERT_EQUAL_UINT32(2, Store.stats.insertions);
+    TEST_ASSERT_EQUAL_size_t(1, test_hash_links(first));
+    test_expect_chunk(index, 0x42);
+}
+
+void test_chunk_store_should_keepWholeWindow_when_capacityEqualsWindow(void)
+{
+    /* Two windows of TEST_CAPACITY chunks; the second repeats one chunk of the first */
+    static const uint8_t fills[2][TEST_CAPACITY] = {
+        { 0x01, 0x02, 0x03, 0x04 },
+        { 0x05, 0x02, 0x06, 0x07 },
+    };
+    danp_ftp_status_t slot_index[TEST_CAPACITY];
+    uint8_t chunk[TEST_CHUNK_SIZE];
+    size_t window;
+    size_t i;
+
+    for (window = 0; window < 2U; window++)
+    {
+        for (i = 0; i < TEST_CAPACITY; i++)
+        {
+            memset(chunk, fills[window][i], sizeof(chunk));
+            slot_index[i] = danp_ftp_chunk_store_insert(&Store, chunk, sizeof(chunk), NULL);
+            TEST_ASSERT_TRUE(slot_index[i] >= 0);
+        }
+
+        /* Every chunk of the window is still there when the peer asks for it */
+        for (i = 0; i < TEST_CAPACITY; i++)
+        {
+            test_expect_chunk(slot_index[i], fills[window][i]);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_size_t(TEST_CAPACITY, Store.count);
+    TEST_ASSERT_EQUAL_UINT32(3, Store.stats.evictions);
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_chunk_store_should_evictLeastRecentlyUsed_when_full);
+    RUN_TEST(test_chunk_store_should_unlinkEvictedEntry_from_sharedBucket);
+    RUN_TEST(test_chunk_store_should_shareEntry_when_hashRepeatsInWindow);
+    RUN_TEST(test_chunk_store_should_keepWholeWindow_when_capacityEqualsWindow);
+    return UNITY_END();
+}
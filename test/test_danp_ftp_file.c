@@ -0,0 +1,147 @@
+/* test_danp_ftp_file.c - tests of the POSIX file source and sink adapters */
+
+/* All Rights Reserved */
+
+/* Includes */
+
+#if !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "danp/ftp/danp_ftp_file.h"
+#include "unity.h"
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Imports */
+
+
+/* Definitions */
+
+#define TEST_FILE_PATH                        "test_danp_ftp_file.bin"
+#define TEST_CHUNK_SIZE                       (100U)
+
+/* Types */
+
+
+/* Forward Declarations */
+
+
+/* Variables */
+
+static danp_ftp_fd_file_t Source;
+static uint8_t Chunk[TEST_CHUNK_SIZE];
+
+/* Functions */
+
+/**
+ * @brief Writes a file of the given size filled with a byte pattern.
+ * @param size File size in bytes.
+ */
+static void test_write_file(size_t size)
+{
+    uint8_t byte;
+    size_t i;
+    int fd;
+
+    fd = open(TEST_FILE_PATH, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    TEST_ASSERT_TRUE(fd >= 0);
+
+    for (i = 0; i < size; i++)
+    {
+        byte = (uint8_t)i;
+        TEST_ASSERT_EQUAL(1, write(fd, &byte, 1));
+    }
+
+    close(fd);
+}
+
+/**
+ * @brief Reads the chunk at an offset through the pread source.
+ * @param offset Offset of the chunk.
+ * @param more Pointer to store the more flag.
+ * @return Number of bytes read or negative status code.
+ */
+static danp_ftp_status_t test_read_chunk(size_t offset, uint8_t *more)
+{
+    *more = 0xFF;
+
+    return danp_ftp_fd_source_cb(NULL, offset, Chunk, TEST_CHUNK_SIZE, more, &Source);
+}
+
+void setUp(void)
+{
+    memset(&Source, 0, sizeof(Source));
+    Source.fd = -1;
+}
+
+void tearDown(void)
+{
+    if (Source.fd >= 0)
+    {
+        close(Source.fd);
+    }
+    unlink(TEST_FILE_PATH);
+}
+
+void test_fd_source_should_flagLastChunk_when_sizeIsChunkMultiple(void)
+{
+    uint8_t more;
+
+    test_write_file(2U * TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_OK, danp_ftp_fd_open_source(&Source, TEST_FILE_PATH));
+    TEST_ASSERT_EQUAL_size_t(2U * TEST_CHUNK_SIZE, Source.size);
+
+    TEST_ASSERT_EQUAL(TEST_CHUNK_SIZE, test_read_chunk(0, &more));
+    TEST_ASSERT_EQUAL_UINT8(1, more);
+
+    TEST_ASSERT_EQUAL(TEST_CHUNK_SIZE, test_read_chunk(TEST_CHUNK_SIZE, &more));
+    TEST_ASSERT_EQUAL_UINT8(0, more);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)(2U * TEST_CHUNK_SIZE - 1U), Chunk[TEST_CHUNK_SIZE - 1U]);
+}
+
+void test_fd_source_should_flagLastChunk_when_lastChunkIsShort(void)
+{
+    uint8_t more;
+
+    test_write_file(TEST_CHUNK_SIZE + 20U);
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_OK, danp_ftp_fd_open_source(&Source, TEST_FILE_PATH));
+
+    TEST_ASSERT_EQUAL(TEST_CHUNK_SIZE, test_read_chunk(0, &more));
+    TEST_ASSERT_EQUAL_UINT8(1, more);
+
+    TEST_ASSERT_EQUAL(20, test_read_chunk(TEST_CHUNK_SIZE, &more));
+    TEST_ASSERT_EQUAL_UINT8(0, more);
+}
+
+void test_fd_source_should_returnNothing_when_fileIsEmpty(void)
+{
+    uint8_t more;
+
+    test_write_file(0);
+    TEST_ASSERT_EQUAL(DANP_FTP_STATUS_OK, danp_ftp_fd_open_source(&Source, TEST_FILE_PATH));
+    TEST_ASSERT_EQUAL_size_t(0, Source.size);
+
+    TEST_ASSERT_EQUAL(0, test_read_chunk(0, &more));
+    TEST_ASSERT_EQUAL_UINT8(0, more);
+}
+
+void test_fd_source_should_reportNotFound_when_fileIsMissing(void)
+{
+    unlink(TEST_FILE_PATH);
+
+    TEST_ASSERT_EQUAL(
+        DANP_FTP_STATUS_FILE_NOT_FOUND,
+        danp_ftp_fd_open_source(&Source, TEST_FILE_PATH));
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fd_source_should_flagLastChunk_when_sizeIsChunkMultiple);
+    RUN_TEST(test_fd_source_should_flagLastChunk_when_lastChunkIsShort);
+    RUN_TEST(test_fd_source_should_returnNothing_when_fileIsEmpty);
+    RUN_TEST(test_fd_source_should_reportNotFound_when_fileIsMissing);
+    return UNITY_END();
+}